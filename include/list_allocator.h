@@ -0,0 +1,51 @@
+#ifndef LIST_ALLOCATOR_H_INCLUDED
+#define LIST_ALLOCATOR_H_INCLUDED
+
+#include <stddef.h>
+
+// Where a list gets its node memory from. Sizes are passed back on realloc
+// and free so that arenas and pools need no per-block headers. Blocks need
+// not be zeroed. A descriptor with alloc == nullptr means malloc/realloc/free.
+struct list_allocator_t {
+    void* (*alloc)  (void* ctx, size_t bytes);
+    void* (*realloc)(void* ctx, void* block, size_t old_bytes, size_t new_bytes);
+    void  (*free)   (void* ctx, void* block, size_t bytes);
+    void*   ctx;
+};
+
+//------------------------------------------------------------------------------
+// Bump arena: allocation is a pointer bump inside big slabs, free only rolls
+// back the most recent block, and everything is released at once by
+// list_arena_reset/list_arena_destroy. Lists living in an arena must not be
+// touched after the reset.
+
+struct list_arena_slab_t;
+
+struct list_arena_t {
+    list_arena_slab_t* top;
+    size_t             slab_bytes;
+    void*              last_block;  // may still grow or shrink in place
+};
+
+void             list_arena_init     (list_arena_t* arena, size_t slab_bytes);
+void             list_arena_reset    (list_arena_t* arena);
+void             list_arena_destroy  (list_arena_t* arena);
+list_allocator_t list_arena_allocator(list_arena_t* arena);
+
+//------------------------------------------------------------------------------
+// Fixed-size block pool: requests up to block_bytes are served from a free
+// chain of equal blocks (e.g. node chunks, or the storage of many lists of one
+// capacity), bigger ones go to malloc.
+
+struct list_pool_t {
+    size_t block_bytes;
+    size_t blocks_per_slab;
+    void*  free_blocks;
+    void*  slabs;
+};
+
+void             list_pool_init     (list_pool_t* pool, size_t block_bytes, size_t blocks_per_slab);
+void             list_pool_destroy  (list_pool_t* pool);
+list_allocator_t list_pool_allocator(list_pool_t* pool);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LIST_BENCH_H_INCLUDED
+#define LIST_BENCH_H_INCLUDED
+
+#include "error_handler.h"
+#include <stddef.h>
+
+// Runs benchmark `name` on lists of `elem_count` elements (0 => default size).
+// Meant for the release build produced by `make bench`.
+error_code list_run_benchmark(const char* name, size_t elem_count);
+
+#endif
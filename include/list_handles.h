@@ -0,0 +1,60 @@
+#ifndef LIST_HANDLES_H_INCLUDED
+#define LIST_HANDLES_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+#include <stdint.h>
+
+// Stable node handles: a handle names a node rather than a slot, so it stays
+// valid while linearize, list_swap, shrinking and compaction move the node.
+// Handles go through an id table kept in sync by the mutation hooks; removing
+// the node bumps the id's generation, so stale handles resolve to -1.
+struct list_handle_t {
+    list_index_t id;
+    uint32_t     generation;
+};
+
+static const list_handle_t LIST_HANDLE_NULL = {-1, 0};
+
+struct list_handle_table_t {
+    list_index_t* id_of;            // physical slot -> handle id, -1 if none was taken
+    list_index_t* origin;           // physical slot -> slot at list_remap_begin, -1 for newer nodes;
+                                    // nullptr unless a remap is being recorded
+    size_t        capacity;         // entries in id_of / origin
+    size_t        origin_capacity;  // list capacity at list_remap_begin
+
+    list_index_t* slot_of;          // handle id -> physical slot, -1 for released ids
+    uint32_t*     generation;       // handle id -> generation, bumped on release
+    list_index_t* free_ids;         // released ids, reused last in first out
+    size_t        free_count;
+    size_t        id_count;
+    size_t        id_capacity;
+};
+
+// Refused for pool lists. Ids are only taken by list_handle_of, so a list
+// that never asks for a handle pays one slot -> id array.
+error_code    list_handles_enable (list_t* list);
+void          list_handles_disable(list_t* list);
+
+// Handle of a live node, LIST_HANDLE_NULL on failure
+list_handle_t list_handle_of     (list_t* list, ssize_t physical_index);
+// Current slot of the handle's node, -1 once it was removed
+ssize_t       list_handle_resolve(const list_t* list, list_handle_t handle);
+
+// Records where nodes move between begin and end: remap (capacity entries,
+// as of list_remap_begin) receives old slot -> new slot, -1 for slots that
+// were free or whose node was removed. Enables handles if they are off.
+error_code    list_remap_begin(list_t* list);
+error_code    list_remap_end  (list_t* list, list_index_t* remap);
+
+//------------------------------------------------------------------------------
+// Maintenance entry points used by list_operations.cpp
+
+error_code handles_reserve (list_t* list, size_t capacity);
+void       handles_link    (list_t* list, ssize_t idx);
+void       handles_unlink  (list_t* list, ssize_t idx);
+void       handles_swap    (list_t* list, ssize_t first_idx, ssize_t second_idx);
+error_code handles_relocate(list_t* list, const list_index_t* remap);
+error_code handles_verify  (const list_t* list, const char** error_description);
+
+#endif
@@ -2,8 +2,11 @@
 #define LIST_H_INCLUDED
 
 #include "error_handler.h"
+#include "list_allocator.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 
 static const size_t MIN_LIST_SIZE    = 3;
 static const int    POISON           = -100;
@@ -20,11 +23,26 @@ static const float  CANARY_NUM       = 0xDEADBEEF;
 
 #define VER_INIT ver_info_t{__FILE__, __func__, __LINE__}
 
-struct node_t {
-    ssize_t next;
-    ssize_t prev;
-    double val;
-};
+// LIST_INDEX_32 narrows node links to 32 bits (-1 / POISON keep their meaning),
+// shrinking a node from 24 to 16 bytes for lists below 2^31 slots.
+#ifdef LIST_INDEX_32
+    typedef int32_t list_index_t;
+    static const size_t LIST_MAX_CAPACITY = INT32_MAX;
+#else
+    typedef ssize_t list_index_t;
+    static const size_t LIST_MAX_CAPACITY = SSIZE_MAX;
+#endif
+
+// LIST_INLINE_NODES=n gives every list_t room for n slots (sentinel included):
+// flat lists that fit keep their nodes inside the list_t and only move to the
+// heap when they first outgrow it.
+#ifdef LIST_INLINE_NODES
+    static const size_t LIST_INLINE_SLOTS = (size_t)LIST_INLINE_NODES ON_DEBUG(+ 1);
+#endif
+
+static inline list_index_t as_index(ssize_t idx) {
+    return (list_index_t)idx;
+}
 
 struct ver_info_t {
     const char* file;
@@ -32,24 +50,222 @@ struct ver_info_t {
     int         line;
 };
 
+#ifndef LIST_SOA
+struct node_t {
+    list_index_t next;
+    list_index_t prev;
+    double val;
+};
+#endif
+
+// Chunked storage keeps nodes in fixed-size chunks behind a directory:
+// growth adds a chunk instead of reallocating, so nodes never move.
+// Mapped storage is flat, but lives in a large anonymous mmap reservation
+// that grows in place (mremap past it) and hands freed tails back to the
+// kernel; the _HUGE variant also asks for transparent huge pages.
+enum list_storage_kind_t {
+    LIST_STORAGE_FLAT        = 0,
+    LIST_STORAGE_CHUNKED     = 1,
+    LIST_STORAGE_MAPPED      = 2,
+    LIST_STORAGE_MAPPED_HUGE = 3,
+};
+
+static const int    LIST_CHUNK_SHIFT = 12;
+static const size_t LIST_CHUNK_NODES = (size_t)1 << LIST_CHUNK_SHIFT;
+
+struct node_chunk_t {
+#ifdef LIST_SOA
+    list_index_t next[LIST_CHUNK_NODES];
+    list_index_t prev[LIST_CHUNK_NODES];
+    double       val [LIST_CHUNK_NODES];
+#else
+    node_t nodes[LIST_CHUNK_NODES];
+#endif
+};
+
+// Automatic shrinking on the remove paths: once size drops below
+// capacity / reduction_factor, live nodes above the new capacity are moved
+// into free slots below it and the storage is cut to size * headroom.
+// Moved nodes change physical index. A reduction_factor of 0 (the default)
+// never shrinks.
+struct list_shrink_policy_t {
+    float  reduction_factor;
+    float  headroom;
+    size_t min_capacity;
+};
+
+static const list_shrink_policy_t LIST_SHRINK_DEFAULT = {REDUCTION_FACTOR, GROWTH_FACTOR, MIN_LIST_SIZE};
+
+// Automatic linearize on the insert / remove paths: fires once list_locality
+// is below min_locality, the list holds at least min_size nodes and
+// amortize * size mutations happened since the last relayout, so the O(n)
+// pass is paid for by the operations that scattered the list. Every node
+// changes physical index then. A min_locality of 0 (the default) never fires.
+struct list_relayout_policy_t {
+    float  min_locality;
+    float  amortize;
+    size_t min_size;
+};
+
+static const list_relayout_policy_t LIST_RELAYOUT_DEFAULT = {0.5f, 1.0f, 64};
+
+struct list_order_index_t;
+struct list_handle_table_t;
+struct list_value_index_t;
+struct list_node_pool_t;
+
 struct list_t {
+    // LIST_SOA keeps next/prev/val in three separate arrays instead of one
+    // node_t array, so that link-only walks do not drag values through cache.
+#ifdef LIST_SOA
+    list_index_t* next;
+    list_index_t* prev;
+    double*       val;
+#else
     node_t* arr;
+#endif
+    // LIST_STORAGE_CHUNKED: the flat pointers above stay nullptr
+    list_storage_kind_t storage_kind;
+    node_chunk_t**      chunks;
+    size_t              chunk_count;
+    size_t              chunk_dir_capacity;
+    size_t              mapped_slots;  // LIST_STORAGE_MAPPED*: slots reserved per array
+    list_allocator_t    allocator;     // node memory for flat and chunked storage
+
     size_t  capacity;
     size_t  size;
 
     ssize_t head;
     ssize_t tail;
     ssize_t free_head;
+    size_t  untouched;      // slots [untouched, capacity) were never handed out and hold garbage
+    size_t  linear_prefix;  // logical [0, linear_prefix) sit in physical [1, linear_prefix]
+    list_order_index_t* order_index;  // nullptr unless list_order_index_enable was called
+    list_handle_table_t* handles;     // nullptr unless list_handles_enable was called
+    list_value_index_t*  value_index; // nullptr unless list_value_index_enable was called
+    list_shrink_policy_t shrink_policy;
+    size_t  compact_budget; // nodes settled after each insert / remove (list_set_compact_budget)
+    size_t  seq_links;      // links a -> a + 1, sentinel -> head included; size - 1 when linear
+    size_t  mutations;      // inserted and removed nodes since the last relayout
+    list_relayout_policy_t relayout_policy;
+    ssize_t finger_logical;  // last position resolved by logical index,
+    ssize_t finger_physical; // kept valid across mutations; physical 0 when unset
+
+    // A list living in a shared node pool owns no storage: nodes, capacity,
+    // free chain and untouched tail are the pool's, and link 0 stands for the
+    // list's own sentinel slot.
+    list_node_pool_t* pool;
+    ssize_t           sentinel;
     ON_DEBUG(
         ver_info_t ver_info;
         FILE* dump_file;
     )
+
+    // While the flat pointers point here, the list must not be copied by value
+#ifdef LIST_INLINE_NODES
+#ifdef LIST_SOA
+    list_index_t inline_next[LIST_INLINE_SLOTS];
+    list_index_t inline_prev[LIST_INLINE_SLOTS];
+    double       inline_val [LIST_INLINE_SLOTS];
+#else
+    node_t       inline_nodes[LIST_INLINE_SLOTS];
+#endif
+#endif
 };
+
+// Many small lists sharing one node array and one free chain. `store` owns
+// the storage but links no nodes itself; its size counts every slot in use.
+struct list_node_pool_t {
+    list_t store;
+};
+
+static inline const list_t* list_store(const list_t* list) {
+    return list->pool != nullptr ? &list->pool->store : list;
+}
+static inline list_t* list_store(list_t* list) {
+    return list->pool != nullptr ? &list->pool->store : list;
+}
+
+static inline ssize_t node_slot(const list_t* list, ssize_t idx) {
+    return idx == 0 ? list->sentinel : idx;
+}
+
+static inline node_chunk_t* chunk_of(const list_t* list, ssize_t idx) {
+    return list->chunks[(size_t)idx >> LIST_CHUNK_SHIFT];
+}
+
+static inline size_t chunk_slot(ssize_t idx) {
+    return (size_t)idx & (LIST_CHUNK_NODES - 1);
+}
+
+#ifdef LIST_SOA
+static inline list_index_t& node_next(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->next[chunk_slot(idx)];
+    return store->next[idx];
+}
+static inline list_index_t& node_prev(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->prev[chunk_slot(idx)];
+    return store->prev[idx];
+}
+static inline double& node_val(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->val[chunk_slot(idx)];
+    return store->val[idx];
+}
+#else
+static inline list_index_t& node_next(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->nodes[chunk_slot(idx)].next;
+    return store->arr[idx].next;
+}
+static inline list_index_t& node_prev(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->nodes[chunk_slot(idx)].prev;
+    return store->arr[idx].prev;
+}
+static inline double& node_val(const list_t* list, ssize_t idx) {
+    const list_t* store = list_store(list);
+    idx = node_slot(list, idx);
+    if (store->chunks != nullptr) return chunk_of(store, idx)->nodes[chunk_slot(idx)].val;
+    return store->arr[idx].val;
+}
+#endif
+
+static inline bool list_storage_ok(const list_t* list) {
+    list = list_store(list);
+    if (list->storage_kind == LIST_STORAGE_CHUNKED) {
+        return list->chunks != nullptr;
+    }
+#ifdef LIST_SOA
+    return list->next != nullptr && list->prev != nullptr && list->val != nullptr;
+#else
+    return list->arr != nullptr;
+#endif
+}
+
  //На будущее новые фугкции дял поулчения и вставки элементов
  //Полная задача структуры node
-static inline bool list_node_is_free(const node_t* node) {
-    return node->prev == POISON || node->val == POISON;
+static inline bool list_node_is_free(const list_t* list, ssize_t idx) {
+    return (size_t)idx >= list_store(list)->untouched ||
+           node_prev(list, idx) == POISON || node_val(list, idx) == POISON;
+}
+
+static inline bool list_is_linear(const list_t* list) {
+    return list->linear_prefix + 1 == list->size;
 }
 
+// Share of links that step to the next physical slot: 1 for a linear list,
+// near 0 for one scattered by random inserts and removes.
+static inline double list_locality(const list_t* list) {
+    if (list->size <= 1) return 1.0;
+    return (double)list->seq_links / (double)(list->size - 1);
+}
 
-#endif /* LIST_H_INCLUDED */
\ No newline at end of file
+#endif /* LIST_H_INCLUDED */
@@ -0,0 +1,168 @@
+#ifndef LIST_ITERATOR_H_INCLUDED
+#define LIST_ITERATOR_H_INCLUDED
+
+#include "list_info.h"
+
+#include <stddef.h>
+#include <iterator>
+
+// Iterators over a list_t in logical order. They dereference to the node's
+// value and expose the physical index through index(); the sentinel (0) is
+// the end of both directions, so --end() is the tail. They work with every
+// storage backend and with pool lists.
+//
+//     for (double& val : list_range(&list)) ...
+//     std::find(list_begin(&list), list_end(&list), 4.0)
+//
+// Removing the node an iterator points at invalidates it; other mutations
+// leave it valid unless they move nodes (linearize, shrink, swap, relayout).
+
+template <bool Reverse>
+struct list_basic_iterator_t {
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef double                          value_type;
+    typedef ptrdiff_t                       difference_type;
+    typedef double*                         pointer;
+    typedef double&                         reference;
+
+    const list_t* list;
+    ssize_t       idx;
+
+    double& operator*()  const { return  node_val(list, idx); }
+    double* operator->() const { return &node_val(list, idx); }
+    ssize_t index()      const { return idx; }
+
+    list_basic_iterator_t& operator++() {
+        idx = Reverse ? node_prev(list, idx) : node_next(list, idx);
+        return *this;
+    }
+    list_basic_iterator_t& operator--() {
+        idx = Reverse ? node_next(list, idx) : node_prev(list, idx);
+        return *this;
+    }
+    list_basic_iterator_t operator++(int) { list_basic_iterator_t old = *this; ++*this; return old; }
+    list_basic_iterator_t operator--(int) { list_basic_iterator_t old = *this; --*this; return old; }
+
+    bool operator==(const list_basic_iterator_t& other) const { return idx == other.idx; }
+    bool operator!=(const list_basic_iterator_t& other) const { return idx != other.idx; }
+};
+
+typedef list_basic_iterator_t<false> list_iterator_t;
+typedef list_basic_iterator_t<true>  list_reverse_iterator_t;
+
+static inline list_iterator_t list_begin(const list_t* list) {
+    return list_iterator_t{list, node_next(list, 0)};
+}
+static inline list_iterator_t list_end(const list_t* list) {
+    return list_iterator_t{list, 0};
+}
+static inline list_reverse_iterator_t list_rbegin(const list_t* list) {
+    return list_reverse_iterator_t{list, node_prev(list, 0)};
+}
+static inline list_reverse_iterator_t list_rend(const list_t* list) {
+    return list_reverse_iterator_t{list, 0};
+}
+
+template <typename Iterator>
+struct list_range_t {
+    Iterator first;
+    Iterator last;
+
+    Iterator begin() const { return first; }
+    Iterator end()   const { return last;  }
+};
+
+static inline list_range_t<list_iterator_t> list_range(const list_t* list) {
+    return {list_begin(list), list_end(list)};
+}
+static inline list_range_t<list_reverse_iterator_t> list_reverse_range(const list_t* list) {
+    return {list_rbegin(list), list_rend(list)};
+}
+
+//==============================================================================
+// Prefetching traversal
+
+// How a prefetching walk guesses the nodes ahead:
+// - CHAIN follows the links with a second cursor `distance` hops ahead and
+//   prefetches each node it reaches. The guess is always right, but that
+//   cursor still pays for every miss in turn.
+// - PHYSICAL prefetches slot idx + distance. There are no dependent loads,
+//   and it is right wherever the list is locally linear.
+// - AUTO picks PHYSICAL when list_locality is at least
+//   LIST_PREFETCH_LOCALITY, and CHAIN otherwise.
+enum list_prefetch_mode_t {
+    LIST_PREFETCH_AUTO,
+    LIST_PREFETCH_CHAIN,
+    LIST_PREFETCH_PHYSICAL,
+};
+
+static const double LIST_PREFETCH_LOCALITY = 0.5;
+
+// What a forward walk reads: the next link and the value
+static inline void list_prefetch_node(const list_t* list, ssize_t idx) {
+    __builtin_prefetch(&node_next(list, idx));
+#ifdef LIST_SOA
+    __builtin_prefetch(&node_val(list, idx));
+#endif
+}
+
+// Forward iterator that prefetches `distance` nodes ahead (0: plain walk)
+struct list_prefetch_iterator_t {
+    typedef std::forward_iterator_tag iterator_category;
+    typedef double                    value_type;
+    typedef ptrdiff_t                 difference_type;
+    typedef double*                   pointer;
+    typedef double&                   reference;
+
+    const list_t* list;
+    ssize_t       idx;
+    ssize_t       ahead;     // CHAIN: node `distance` hops past idx, 0 past the tail
+    ssize_t       distance;
+    ssize_t       slot_end;  // PHYSICAL: slots at or past it hold no nodes
+    bool          physical;
+
+    double& operator*()  const { return  node_val(list, idx); }
+    double* operator->() const { return &node_val(list, idx); }
+    ssize_t index()      const { return idx; }
+
+    list_prefetch_iterator_t& operator++() {
+        idx = node_next(list, idx);
+        if (physical) {
+            if (idx + distance < slot_end) list_prefetch_node(list, idx + distance);
+        } else if (ahead != 0) {
+            ahead = node_next(list, ahead);
+            list_prefetch_node(list, ahead);
+        }
+        return *this;
+    }
+    list_prefetch_iterator_t operator++(int) { list_prefetch_iterator_t old = *this; ++*this; return old; }
+
+    bool operator==(const list_prefetch_iterator_t& other) const { return idx == other.idx; }
+    bool operator!=(const list_prefetch_iterator_t& other) const { return idx != other.idx; }
+};
+
+static inline list_range_t<list_prefetch_iterator_t> list_prefetch_range(const list_t* list, size_t distance,
+                                                                       list_prefetch_mode_t mode) {
+    if (mode == LIST_PREFETCH_AUTO) {
+        mode = list_locality(list) >= LIST_PREFETCH_LOCALITY ? LIST_PREFETCH_PHYSICAL : LIST_PREFETCH_CHAIN;
+    }
+    list_prefetch_iterator_t first = {};
+    first.list     = list;
+    first.idx      = node_next(list, 0);
+    first.distance = (ssize_t)distance;
+    first.slot_end = (ssize_t)list_store(list)->untouched;
+    first.physical = distance > 0 && mode == LIST_PREFETCH_PHYSICAL;
+
+    if (!first.physical && distance > 0) {
+        first.ahead = first.idx;
+        for (size_t hop = 0; hop < distance && first.ahead != 0; ++hop) {
+            list_prefetch_node(list, first.ahead);
+            first.ahead = node_next(list, first.ahead);
+        }
+    }
+    list_prefetch_iterator_t last = first;
+    last.idx = 0;
+    return {first, last};
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef LIST_LRU_H_INCLUDED
+#define LIST_LRU_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+
+// Fixed-size LRU cache: a list_t in recency order (most recent at head)
+// whose node values are the keys, with the list's value index as the
+// key -> node map. Payloads sit in an array parallel to the node slots;
+// hits are promoted with list_move_to_front, so nodes never change slot.
+struct list_lru_t {
+    list_t  list;
+    double* payload;
+    size_t  payload_capacity;
+    size_t  max_entries;
+};
+
+error_code list_lru_init(list_lru_t* lru, size_t max_entries ON_DEBUG(, ver_info_t ver_info));
+error_code list_lru_dest(list_lru_t* lru);
+
+// true on a hit: *value_return gets the payload and the key becomes the most recent
+bool       list_lru_get(list_lru_t* lru, double key, double* value_return);
+
+// Inserts or updates key as the most recent entry. A full cache evicts its
+// least recent entry first; *evicted_return (if given) tells whether it did.
+error_code list_lru_put(list_lru_t* lru, double key, double value, bool* evicted_return);
+
+static inline size_t list_lru_size(const list_lru_t* lru) {
+    return lru->list.size - 1;
+}
+
+#endif
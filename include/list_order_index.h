@@ -0,0 +1,44 @@
+#ifndef LIST_ORDER_INDEX_H_INCLUDED
+#define LIST_ORDER_INDEX_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+#include <stdint.h>
+
+// Optional order-statistic index over the live nodes of a list: an implicit
+// treap whose in-order sequence is the logical order. Tree links live in
+// arrays parallel to the node storage and are keyed by physical index; slot 0
+// (the sentinel) is never in the tree and doubles as the null link.
+struct list_order_index_t {
+    list_index_t* left;
+    list_index_t* right;
+    list_index_t* parent;
+    list_index_t* count;
+    uint32_t*     prio;
+    size_t        capacity;
+    list_index_t  root;
+    uint64_t      seed;
+    bool          stale;  // set by bulk relinks, rebuilt on next lookup
+};
+
+error_code list_order_index_enable (list_t* list);
+void       list_order_index_disable(list_t* list);
+
+// logical position of a live physical node, O(log n) with the index enabled
+ssize_t    list_logical_index(list_t* list, ssize_t physical_index);
+
+//------------------------------------------------------------------------------
+// Maintenance entry points used by list_operations.cpp
+
+error_code order_index_reserve     (list_t* list, size_t capacity);
+void       order_index_insert_after(list_t* list, ssize_t after_idx, ssize_t idx);
+void       order_index_insert_run  (list_t* list, ssize_t after_idx, ssize_t first_idx, size_t count);
+void       order_index_remove      (list_t* list, ssize_t idx);
+void       order_index_remove_range(list_t* list, ssize_t first_idx, ssize_t last_idx);
+void       order_index_move_range  (list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t after_idx);
+void       order_index_swap        (list_t* list, ssize_t first_idx, ssize_t second_idx);
+void       order_index_invalidate  (list_t* list);
+ssize_t    order_index_select      (const list_t* list, ssize_t logical_index);
+error_code order_index_verify      (const list_t* list, const char** error_description);
+
+#endif
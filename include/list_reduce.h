@@ -0,0 +1,35 @@
+#ifndef LIST_REDUCE_H_INCLUDED
+#define LIST_REDUCE_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+
+// Reductions over a list's values. They scan physical slots rather than
+// walking the chain. Free slots are masked out by the list_node_is_free
+// rules: prev == POISON or val == POISON, so a live -100.0 is skipped too.
+// A linear list only scans slots 1..size-1. Pool lists walk their chain,
+// since the pool's slots belong to other lists as well.
+//
+// The kernels come in scalar, SSE2 and AVX2 versions, and the best one the
+// CPU supports is picked on first use. The sum is added up in slot order,
+// so its rounding can differ from a walk in logical order. NaN values show
+// up in the sum; min / max / count skip them.
+enum list_simd_level_t {
+    LIST_SIMD_SCALAR,
+    LIST_SIMD_SSE2,
+    LIST_SIMD_AVX2,
+};
+
+// The level in use, and a way to cap it (e.g. to compare the paths);
+// a level the CPU lacks is lowered to what it has
+list_simd_level_t list_simd_level();
+list_simd_level_t list_simd_force(list_simd_level_t level);
+
+double     list_reduce_sum(const list_t* list);
+// ERROR_MISSED_ELEM for an empty list
+error_code list_min(const list_t* list, double* min_return);
+error_code list_max(const list_t* list, double* max_return);
+// Values with lo <= val <= hi
+size_t     list_count_if_range(const list_t* list, double lo, double hi);
+
+#endif
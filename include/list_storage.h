@@ -0,0 +1,24 @@
+#ifndef LIST_STORAGE_H_INCLUDED
+#define LIST_STORAGE_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+
+// Raw node memory management. Slot contents are left to the caller; in debug
+// builds one extra slot past capacity is reserved for the right canary.
+// The backend (flat arrays or chunks) is picked by list->storage_kind.
+error_code list_storage_alloc (list_t* list, size_t capacity);
+error_code list_storage_resize(list_t* list, size_t new_capacity);
+void       list_storage_free  (list_t* list);
+// exchanges the node memory of two lists, nothing else
+void       list_storage_swap  (list_t* first, list_t* second);
+// after `from` was copied into list: points list at its own inline slots
+void       list_storage_relocate(list_t* list, list_t* from);
+
+// Capacity actually provided for a request (chunked storage fills whole
+// chunks, flat storage at least the inline slots) and the next capacity to grow to: GROWTH_FACTOR for flat storage,
+// one more chunk for chunked storage.
+size_t     list_storage_fit_capacity (const list_t* list, size_t capacity);
+size_t     list_storage_grow_capacity(const list_t* list);
+
+#endif
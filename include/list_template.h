@@ -0,0 +1,664 @@
+#ifndef LIST_TEMPLATE_H_INCLUDED
+#define LIST_TEMPLATE_H_INCLUDED
+
+#include "list_info.h"
+#include "logger.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <new>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Header-only list over any payload type: tlist_t<T, Index, Debug, Layout>.
+// The operations are overloads of the list_t ones (list_insert_after,
+// list_remove_auto, list_linearize, ...), so code written against one works
+// with the other. list_t stays the double list with all the extras (storage
+// backends, pools, indexes, policies); tlist_t<double> is the plain
+// instantiation with the same node layout.
+//
+// A slot is free when its prev link is -1 (the free chain runs through next
+// only), so payloads never need a reserved POISON value. Payloads are
+// constructed when a slot is handed out and destroyed when it is freed.
+// Trivially copyable payloads are moved with realloc / memcpy on grow, swap
+// and linearize; anything else is move-constructed.
+
+// Debug policies: list_debug_verify checks the structure after every mutation
+struct list_debug_off    { static const bool verify = false; };
+struct list_debug_verify { static const bool verify = true;  };
+
+#ifdef VERIFY_DEBUG
+typedef list_debug_verify list_debug_default;
+#else
+typedef list_debug_off    list_debug_default;
+#endif
+
+// Payload layouts. list_payload_inline keeps the payload in the node;
+// list_payload_arena leaves the node with its links and a 32-bit arena slot,
+// and packs the payloads densely in a separate array (the arena) that
+// list_linearize puts back in logical order. Link-only walks such as
+// list_resolve_auto then touch the same small nodes whatever sizeof(T) is.
+struct list_payload_inline { static const bool out_of_line = false; };
+struct list_payload_arena  { static const bool out_of_line = true;  };
+
+template <typename T, typename Index, typename Layout>
+struct tlist_node_t {
+    Index next;
+    Index prev;  // -1: free slot
+    alignas(T) unsigned char payload[sizeof(T)];
+};
+
+template <typename T, typename Index>
+struct tlist_node_t<T, Index, list_payload_arena> {
+    Index    next;
+    Index    prev;  // -1: free slot
+    uint32_t slot;  // payload position in the arena
+};
+
+template <typename T, typename Index = list_index_t, typename Debug = list_debug_default,
+          typename Layout = list_payload_inline>
+struct tlist_t {
+    static_assert(std::is_integral<Index>::value && std::is_signed<Index>::value,
+                  "Index must be a signed integer type");
+
+    typedef T                              value_type;
+    typedef tlist_node_t<T, Index, Layout> node_type;
+
+    static const bool trivial     = std::is_trivially_copyable<T>::value;
+    static const bool out_of_line = Layout::out_of_line;
+    // node blocks can be moved bytewise
+    static const bool nodes_trivial = trivial || out_of_line;
+
+    node_type* nodes;
+    size_t     capacity;
+    size_t     size;       // live nodes + the sentinel
+    size_t     untouched;  // slots [untouched, capacity) were never handed out
+    ssize_t    head;
+    ssize_t    tail;
+    ssize_t    free_head;
+
+    // list_payload_arena only: payloads of the size - 1 live nodes sit in
+    // arena[0, size - 1), arena_owner[k] is the node holding arena[k]
+    T*         arena;
+    Index*     arena_owner;
+    size_t     arena_capacity;
+};
+
+#ifndef LIST_SOA
+static_assert(sizeof(tlist_node_t<double, list_index_t, list_payload_inline>) == sizeof(node_t),
+              "tlist_t<double> must keep the node_t layout");
+#endif
+
+//==============================================================================
+// Slot access
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline Index& tlist_next(const tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    return list->nodes[idx].next;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline Index& tlist_prev(const tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    return list->nodes[idx].prev;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline T& tlist_val(const tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    if constexpr (Layout::out_of_line) {
+        return list->arena[list->nodes[idx].slot];
+    } else {
+        return *reinterpret_cast<T*>(list->nodes[idx].payload);
+    }
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline bool list_node_is_free(const tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    return (size_t)idx >= list->untouched || list->nodes[idx].prev == -1;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline size_t tlist_max_capacity(const tlist_t<T, Index, Debug, Layout>*) {
+    size_t max_capacity = (size_t)std::numeric_limits<Index>::max();
+    if (Layout::out_of_line && max_capacity > (size_t)UINT32_MAX) {
+        max_capacity = (size_t)UINT32_MAX;
+    }
+    return max_capacity;
+}
+
+//==============================================================================
+// Internals
+
+// Moves the payload of live node src into dst_nodes[dst], which becomes its
+// new home (dst_nodes may be list->nodes or a replacement block). An arena
+// payload stays where it is; only its owner changes.
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline void tlist_payload_move(tlist_t<T, Index, Debug, Layout>* list,
+                                      typename tlist_t<T, Index, Debug, Layout>::node_type* dst_nodes,
+                                      ssize_t dst, ssize_t src) {
+    if constexpr (Layout::out_of_line) {
+        uint32_t slot = list->nodes[src].slot;
+        dst_nodes[dst].slot     = slot;
+        list->arena_owner[slot] = (Index)dst;
+    } else if constexpr (tlist_t<T, Index, Debug, Layout>::trivial) {
+        memcpy(dst_nodes[dst].payload, list->nodes[src].payload, sizeof(T));
+    } else {
+        T& old_val = tlist_val(list, src);
+        new (dst_nodes[dst].payload) T(std::move(old_val));
+        old_val.~T();
+    }
+}
+
+// Constructs the payload of node idx; an arena payload goes to the end of
+// the packed range, which tlist_reserve_arena has made room for
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static inline void tlist_payload_place(tlist_t<T, Index, Debug, Layout>* list, ssize_t idx, U&& val) {
+    if constexpr (Layout::out_of_line) {
+        size_t slot = list->size - 1;
+        new (list->arena + slot) T(std::forward<U>(val));
+        list->arena_owner[slot] = (Index)idx;
+        list->nodes[idx].slot   = (uint32_t)slot;
+    } else {
+        new (list->nodes[idx].payload) T(std::forward<U>(val));
+    }
+}
+
+// Destroys the payload of node idx. The arena stays packed: its last payload
+// moves into the hole.
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline void tlist_payload_drop(tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    if constexpr (Layout::out_of_line) {
+        size_t slot = list->nodes[idx].slot;
+        size_t last = list->size - 2;
+        list->arena[slot].~T();
+        if (slot != last) {
+            if constexpr (tlist_t<T, Index, Debug, Layout>::trivial) {
+                memcpy((void*)(list->arena + slot), (const void*)(list->arena + last), sizeof(T));
+            } else {
+                new (list->arena + slot) T(std::move(list->arena[last]));
+                list->arena[last].~T();
+            }
+            Index owner = list->arena_owner[last];
+            list->arena_owner[slot]  = owner;
+            list->nodes[owner].slot  = (uint32_t)slot;
+        }
+    } else {
+        tlist_val(list, idx).~T();
+    }
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline void tlist_payload_swap(tlist_t<T, Index, Debug, Layout>* list, ssize_t first_idx, ssize_t second_idx) {
+    if constexpr (Layout::out_of_line) {
+        std::swap(list->nodes[first_idx].slot, list->nodes[second_idx].slot);
+        list->arena_owner[list->nodes[first_idx].slot]  = (Index)first_idx;
+        list->arena_owner[list->nodes[second_idx].slot] = (Index)second_idx;
+    } else if constexpr (tlist_t<T, Index, Debug, Layout>::trivial) {
+        unsigned char tmp[sizeof(T)];
+        memcpy(tmp, list->nodes[first_idx].payload, sizeof(T));
+        memcpy(list->nodes[first_idx].payload, list->nodes[second_idx].payload, sizeof(T));
+        memcpy(list->nodes[second_idx].payload, tmp, sizeof(T));
+    } else {
+        using std::swap;
+        swap(tlist_val(list, first_idx), tlist_val(list, second_idx));
+    }
+}
+
+// Moves the packed arena into a block of new_capacity payloads
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code tlist_resize_arena(tlist_t<T, Index, Debug, Layout>* list, size_t new_capacity) {
+    const size_t count = list->size - 1;
+    if (new_capacity < count) {
+        LOGGER_ERROR("tlist: arena capacity %lu below %lu payloads", new_capacity, count);
+        return ERROR_BIG_SIZE;
+    }
+    Index* owner = (Index*)realloc(list->arena_owner, new_capacity * sizeof(Index));
+    if (owner == nullptr) {
+        LOGGER_ERROR("tlist: realloc failed for arena of %lu payloads", new_capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    list->arena_owner = owner;
+
+    T* arena = nullptr;
+    if constexpr (tlist_t<T, Index, Debug, Layout>::trivial) {
+        arena = (T*)realloc((void*)list->arena, new_capacity * sizeof(T));
+    } else {
+        arena = (T*)malloc(new_capacity * sizeof(T));
+        if (arena != nullptr) {
+            for (size_t i = 0; i < count; ++i) {
+                new (arena + i) T(std::move(list->arena[i]));
+                list->arena[i].~T();
+            }
+            free((void*)list->arena);
+        }
+    }
+    if (arena == nullptr) {
+        LOGGER_ERROR("tlist: no memory for arena of %lu payloads", new_capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    list->arena          = arena;
+    list->arena_capacity = new_capacity;
+    return ERROR_NO;
+}
+
+// Room in the arena for one more payload; a no-op for inline payloads
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline error_code tlist_reserve_arena(tlist_t<T, Index, Debug, Layout>* list) {
+    if (!Layout::out_of_line || list->size - 1 < list->arena_capacity) {
+        return ERROR_NO;
+    }
+    size_t new_capacity = (size_t)((double)list->arena_capacity * (double)GROWTH_FACTOR);
+    if (new_capacity < MIN_LIST_SIZE) new_capacity = MIN_LIST_SIZE;
+    return tlist_resize_arena(list, new_capacity);
+}
+
+// Moves the slots [0, untouched) into a block of new_capacity slots; every
+// live slot must fit. Nodes that move bytewise go with realloc.
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code tlist_resize(tlist_t<T, Index, Debug, Layout>* list, size_t new_capacity) {
+    typedef typename tlist_t<T, Index, Debug, Layout>::node_type node_type;
+
+    if (new_capacity > tlist_max_capacity(list) || new_capacity < list->untouched) {
+        LOGGER_ERROR("tlist: capacity %lu out of range", new_capacity);
+        return ERROR_BIG_SIZE;
+    }
+    if (tlist_t<T, Index, Debug, Layout>::nodes_trivial) {
+        node_type* nodes = (node_type*)realloc((void*)list->nodes, new_capacity * sizeof(node_type));
+        if (nodes == nullptr) {
+            LOGGER_ERROR("tlist: realloc failed for %lu slots", new_capacity);
+            return ERROR_MEM_ALLOC;
+        }
+        list->nodes    = nodes;
+        list->capacity = new_capacity;
+        return ERROR_NO;
+    }
+
+    node_type* nodes = (node_type*)malloc(new_capacity * sizeof(node_type));
+    if (nodes == nullptr) {
+        LOGGER_ERROR("tlist: malloc failed for %lu slots", new_capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    for (size_t i = 0; i < list->untouched; ++i) {
+        nodes[i].next = list->nodes[i].next;
+        nodes[i].prev = list->nodes[i].prev;
+        if (i != 0 && !list_node_is_free(list, (ssize_t)i)) {
+            tlist_payload_move(list, nodes, (ssize_t)i, (ssize_t)i);
+        }
+    }
+    free((void*)list->nodes);
+    list->nodes    = nodes;
+    list->capacity = new_capacity;
+    return ERROR_NO;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static ssize_t tlist_take_slot(tlist_t<T, Index, Debug, Layout>* list) {
+    if (list->free_head != -1) {
+        ssize_t idx = list->free_head;
+        list->free_head = tlist_next(list, idx);
+        return idx;
+    }
+    if (list->untouched == list->capacity) {
+        size_t new_capacity = (size_t)((double)list->capacity * (double)GROWTH_FACTOR);
+        if (new_capacity > tlist_max_capacity(list)) new_capacity = tlist_max_capacity(list);
+        if (new_capacity <= list->capacity || tlist_resize(list, new_capacity) != ERROR_NO) {
+            return -1;
+        }
+    }
+    return (ssize_t)list->untouched++;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static void tlist_release_slot(tlist_t<T, Index, Debug, Layout>* list, ssize_t idx) {
+    tlist_payload_drop(list, idx);
+    tlist_prev(list, idx) = -1;
+    tlist_next(list, idx) = (Index)list->free_head;
+    list->free_head = idx;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_verify(const tlist_t<T, Index, Debug, Layout>* list) {
+    if (list->nodes == nullptr || list->capacity == 0 || list->untouched == 0 ||
+        list->untouched > list->capacity || list->size > list->untouched) {
+        LOGGER_ERROR("tlist: bad header (capacity %lu, untouched %lu, size %lu)",
+                     list->capacity, list->untouched, list->size);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    size_t  count = 0;
+    ssize_t prev  = 0;
+    for (ssize_t cur = tlist_next(list, 0); cur != 0; prev = cur, cur = tlist_next(list, cur)) {
+        if (cur < 0 || (size_t)cur >= list->untouched || ++count >= list->size ||
+            list_node_is_free(list, cur) || tlist_prev(list, cur) != prev) {
+            LOGGER_ERROR("tlist: chain broken at %ld", cur);
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    if (count + 1 != list->size || tlist_prev(list, 0) != prev ||
+        list->head != tlist_next(list, 0) || list->tail != prev) {
+        LOGGER_ERROR("tlist: %lu nodes linked, size says %lu", count, list->size - 1);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    size_t free_count = 0;
+    for (ssize_t cur = list->free_head; cur != -1; cur = tlist_next(list, cur)) {
+        if (cur <= 0 || (size_t)cur >= list->untouched || !list_node_is_free(list, cur) ||
+            ++free_count > list->untouched) {
+            LOGGER_ERROR("tlist: free chain broken at %ld", cur);
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    if (free_count + list->size != list->untouched) {
+        LOGGER_ERROR("tlist: %lu free + %lu used != %lu touched slots", free_count, list->size, list->untouched);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    if constexpr (Layout::out_of_line) {
+        if (list->arena_capacity < list->size - 1) {
+            LOGGER_ERROR("tlist: arena of %lu for %lu payloads", list->arena_capacity, list->size - 1);
+            return ERROR_INVALID_STRUCTURE;
+        }
+        for (ssize_t cur = list->head; cur != 0; cur = tlist_next(list, cur)) {
+            size_t slot = list->nodes[cur].slot;
+            if (slot >= list->size - 1 || list->arena_owner[slot] != cur) {
+                LOGGER_ERROR("tlist: node %ld points at arena slot %lu it does not own", cur, slot);
+                return ERROR_INVALID_STRUCTURE;
+            }
+        }
+    }
+    return ERROR_NO;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static inline error_code tlist_checked(tlist_t<T, Index, Debug, Layout>* list, error_code error) {
+    if (Debug::verify && error == ERROR_NO) {
+        error = list_verify(list);
+    }
+    return error;
+}
+
+//==============================================================================
+// Operations
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_init(tlist_t<T, Index, Debug, Layout>* list, size_t capacity) {
+    LOGGER_DEBUG("Initialising tlist with capacity %lu", capacity);
+
+    *list = {};
+    if (capacity < MIN_LIST_SIZE) capacity = MIN_LIST_SIZE;
+    error_code error = tlist_resize(list, capacity);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    tlist_next(list, 0) = 0;
+    tlist_prev(list, 0) = 0;
+    list->size      = 1;
+    list->untouched = 1;
+    list->free_head = -1;
+    return tlist_checked(list, ERROR_NO);
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_dest(tlist_t<T, Index, Debug, Layout>* list) {
+    LOGGER_DEBUG("Destroying tlist");
+
+    if (!std::is_trivially_destructible<T>::value) {
+        for (ssize_t cur = list->head; cur != 0; cur = tlist_next(list, cur)) {
+            tlist_val(list, cur).~T();
+        }
+    }
+    free((void*)list->nodes);
+    free((void*)list->arena);
+    free(list->arena_owner);
+    *list = {};
+    return ERROR_NO;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static ssize_t list_insert_after(tlist_t<T, Index, Debug, Layout>* list, ssize_t insert_index, U&& val) {
+    if (insert_index < 0 || (size_t)insert_index >= list->untouched ||
+        (insert_index != 0 && list_node_is_free(list, insert_index))) {
+        LOGGER_ERROR("tlist: insert_index %ld is not a live node", insert_index);
+        return -1;
+    }
+    ssize_t idx = tlist_reserve_arena(list) == ERROR_NO ? tlist_take_slot(list) : -1;
+    if (idx == -1) {
+        LOGGER_ERROR("tlist: no slot for insert");
+        return -1;
+    }
+    tlist_payload_place(list, idx, std::forward<U>(val));
+
+    ssize_t next_index = tlist_next(list, insert_index);
+    tlist_next(list, idx)          = (Index)next_index;
+    tlist_prev(list, idx)          = (Index)insert_index;
+    tlist_next(list, insert_index) = (Index)idx;
+    tlist_prev(list, next_index)   = (Index)idx;
+    list->head = tlist_next(list, 0);
+    list->tail = tlist_prev(list, 0);
+    list->size++;
+    return tlist_checked(list, ERROR_NO) == ERROR_NO ? idx : -1;
+}
+
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static ssize_t list_insert_before(tlist_t<T, Index, Debug, Layout>* list, ssize_t insert_index, U&& val) {
+    if (insert_index < 0 || (size_t)insert_index >= list->untouched) {
+        LOGGER_ERROR("tlist: insert_index %ld out of range", insert_index);
+        return -1;
+    }
+    return list_insert_after(list, tlist_prev(list, insert_index), std::forward<U>(val));
+}
+
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static ssize_t list_push_back(tlist_t<T, Index, Debug, Layout>* list, U&& val) {
+    return list_insert_after(list, list->tail, std::forward<U>(val));
+}
+
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static ssize_t list_push_front(tlist_t<T, Index, Debug, Layout>* list, U&& val) {
+    return list_insert_after(list, 0, std::forward<U>(val));
+}
+
+// Logical index -> physical slot, walking from whichever end is nearer
+template <typename T, typename Index, typename Debug, typename Layout>
+static ssize_t list_resolve_auto(const tlist_t<T, Index, Debug, Layout>* list, ssize_t logical_index) {
+    const ssize_t count = (ssize_t)list->size - 1;
+    if (logical_index < 0 || logical_index >= count) {
+        LOGGER_ERROR("tlist: logical_index %ld out of range", logical_index);
+        return -1;
+    }
+    ssize_t cur = 0;
+    if (logical_index < count / 2) {
+        for (ssize_t i = -1; i < logical_index; ++i) cur = tlist_next(list, cur);
+    } else {
+        for (ssize_t i = count; i > logical_index; --i) cur = tlist_prev(list, cur);
+    }
+    return cur;
+}
+
+// Inserts after the node at logical insert_index, like list_insert_auto
+template <typename T, typename Index, typename Debug, typename Layout, typename U>
+static ssize_t list_insert_auto(tlist_t<T, Index, Debug, Layout>* list, ssize_t insert_index, U&& val) {
+    ssize_t physical = insert_index == (ssize_t)list->size - 1 ? 0 : list_resolve_auto(list, insert_index);
+    if (physical == -1) {
+        return -1;
+    }
+    return list_insert_after(list, physical, std::forward<U>(val));
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_remove(tlist_t<T, Index, Debug, Layout>* list, ssize_t remove_index) {
+    if (remove_index <= 0 || (size_t)remove_index >= list->untouched || list_node_is_free(list, remove_index)) {
+        LOGGER_ERROR("tlist: %ld is not a live node", remove_index);
+        return ERROR_INCORRECT_INDEX;
+    }
+    ssize_t prev_index = tlist_prev(list, remove_index);
+    ssize_t next_index = tlist_next(list, remove_index);
+    tlist_next(list, prev_index) = (Index)next_index;
+    tlist_prev(list, next_index) = (Index)prev_index;
+    tlist_release_slot(list, remove_index);
+
+    list->head = tlist_next(list, 0);
+    list->tail = tlist_prev(list, 0);
+    list->size--;
+    return tlist_checked(list, ERROR_NO);
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_remove_auto(tlist_t<T, Index, Debug, Layout>* list, ssize_t remove_index) {
+    ssize_t physical = list_resolve_auto(list, remove_index);
+    if (physical == -1) {
+        return ERROR_INCORRECT_INDEX;
+    }
+    return list_remove(list, physical);
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_pop_back(tlist_t<T, Index, Debug, Layout>* list) {
+    return list_remove(list, list->tail);
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_pop_front(tlist_t<T, Index, Debug, Layout>* list) {
+    return list_remove(list, list->head);
+}
+
+// Exchanges the contents of two slots and relinks their neighbours. Two live
+// nodes swap in O(1); a live node moving into a free slot walks the free
+// chain to put the vacated slot in its place.
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_swap(tlist_t<T, Index, Debug, Layout>* list, ssize_t first_idx, ssize_t second_idx) {
+    if (first_idx <= 0 || second_idx <= 0 ||
+        (size_t)first_idx >= list->untouched || (size_t)second_idx >= list->untouched) {
+        LOGGER_ERROR("tlist: swap of %ld and %ld out of range", first_idx, second_idx);
+        return ERROR_INCORRECT_INDEX;
+    }
+    bool first_free  = list_node_is_free(list, first_idx);
+    bool second_free = list_node_is_free(list, second_idx);
+    if (first_idx == second_idx || (first_free && second_free)) {
+        return ERROR_NO;
+    }
+    if (first_free) {
+        std::swap(first_idx, second_idx);
+        second_free = true;
+    }
+
+    if (second_free) {
+        // first_idx's node moves into second_idx, which leaves the free chain
+        ssize_t pred = -1;
+        for (ssize_t cur = list->free_head; cur != second_idx; cur = tlist_next(list, cur)) {
+            pred = cur;
+        }
+        if (pred == -1) list->free_head = first_idx;
+        else            tlist_next(list, pred) = (Index)first_idx;
+        Index free_next = tlist_next(list, second_idx);
+
+        ssize_t next_index = tlist_next(list, first_idx);
+        ssize_t prev_index = tlist_prev(list, first_idx);
+        tlist_payload_move(list, list->nodes, second_idx, first_idx);
+        tlist_next(list, second_idx) = (Index)next_index;
+        tlist_prev(list, second_idx) = (Index)prev_index;
+        tlist_prev(list, next_index) = (Index)second_idx;
+        tlist_next(list, prev_index) = (Index)second_idx;
+        tlist_prev(list, first_idx)  = -1;
+        tlist_next(list, first_idx)  = free_next;
+    } else {
+        ssize_t first_next  = tlist_next(list, first_idx);
+        ssize_t first_prev  = tlist_prev(list, first_idx);
+        ssize_t second_next = tlist_next(list, second_idx);
+        ssize_t second_prev = tlist_prev(list, second_idx);
+        // adjacent nodes point at each other: follow the swap
+        if (first_next  == second_idx) first_next  = first_idx;
+        if (first_prev  == second_idx) first_prev  = first_idx;
+        if (second_next == first_idx)  second_next = second_idx;
+        if (second_prev == first_idx)  second_prev = second_idx;
+
+        tlist_payload_swap(list, first_idx, second_idx);
+        tlist_next(list, first_idx)  = (Index)second_next;
+        tlist_prev(list, first_idx)  = (Index)second_prev;
+        tlist_next(list, second_idx) = (Index)first_next;
+        tlist_prev(list, second_idx) = (Index)first_prev;
+        tlist_prev(list, first_next)  = (Index)second_idx;
+        tlist_next(list, first_prev)  = (Index)second_idx;
+        tlist_prev(list, second_next) = (Index)first_idx;
+        tlist_next(list, second_prev) = (Index)first_idx;
+    }
+    list->head = tlist_next(list, 0);
+    list->tail = tlist_prev(list, 0);
+    return tlist_checked(list, ERROR_NO);
+}
+
+// Out-of-place: nodes are copied in logical order into a fresh block of the
+// same capacity, so logical i ends up in slot i + 1 and nothing is free below
+// untouched. An arena is repacked the same way, logical i to arena[i].
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_linearize(tlist_t<T, Index, Debug, Layout>* list) {
+    typedef typename tlist_t<T, Index, Debug, Layout>::node_type node_type;
+    LOGGER_DEBUG("Linearizing tlist");
+
+    node_type* nodes = (node_type*)malloc(list->capacity * sizeof(node_type));
+    T*         arena = nullptr;
+    if (Layout::out_of_line && nodes != nullptr && list->arena_capacity > 0) {
+        arena = (T*)malloc(list->arena_capacity * sizeof(T));
+        if (arena == nullptr) {
+            free((void*)nodes);
+            nodes = nullptr;
+        }
+    }
+    if (nodes == nullptr) {
+        LOGGER_ERROR("tlist: no memory for linearize");
+        return ERROR_MEM_ALLOC;
+    }
+    const ssize_t n = (ssize_t)list->size - 1;
+    ssize_t cur = list->head;
+    for (ssize_t i = 1; i <= n; ++i, cur = tlist_next(list, cur)) {
+        nodes[i].next = (Index)(i == n ? 0 : i + 1);
+        nodes[i].prev = (Index)(i - 1);
+        if constexpr (Layout::out_of_line) {
+            T& old_val = tlist_val(list, cur);
+            if constexpr (tlist_t<T, Index, Debug, Layout>::trivial) {
+                memcpy((void*)(arena + i - 1), (const void*)&old_val, sizeof(T));
+            } else {
+                new (arena + i - 1) T(std::move(old_val));
+                old_val.~T();
+            }
+            nodes[i].slot            = (uint32_t)(i - 1);
+            list->arena_owner[i - 1]   = (Index)i;
+        } else {
+            tlist_payload_move(list, nodes, i, cur);
+        }
+    }
+    nodes[0].next = (Index)(n > 0 ? 1 : 0);
+    nodes[0].prev = (Index)n;
+
+    free((void*)list->nodes);
+    list->nodes     = nodes;
+    if (Layout::out_of_line) {
+        free((void*)list->arena);
+        list->arena = arena;
+    }
+    list->untouched = (size_t)n + 1;
+    list->free_head = -1;
+    list->head      = tlist_next(list, 0);
+    list->tail      = tlist_prev(list, 0);
+    return tlist_checked(list, ERROR_NO);
+}
+
+template <typename T, typename Index, typename Debug, typename Layout>
+static error_code list_shrink_to_fit(tlist_t<T, Index, Debug, Layout>* list, bool keep_growth) {
+    LOGGER_DEBUG("Shrinking tlist to fit (keep_growth=%d)", (int)keep_growth);
+
+    error_code error = list_linearize(list);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    size_t target = keep_growth ? (size_t)((double)list->size * (double)GROWTH_FACTOR) : list->size;
+    if (target < MIN_LIST_SIZE) target = MIN_LIST_SIZE;
+    if (Layout::out_of_line && target - 1 < list->arena_capacity) {
+        error = tlist_resize_arena(list, target - 1);
+    }
+    if (error == ERROR_NO && target < list->capacity) {
+        error = tlist_resize(list, target);
+    }
+    return tlist_checked(list, error);
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef LIST_UNROLLED_H_INCLUDED
+#define LIST_UNROLLED_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+#include <stdint.h>
+
+// Unrolled list: an array-backed doubly linked list of blocks, each holding
+// up to UNROLLED_BLOCK values in order. A scan or a positional search visits
+// one block per UNROLLED_BLOCK values instead of one node per value.
+//
+// Block 0 is the sentinel, as in list_t. An insert into the middle of a full
+// block splits it in two; one at either end of it goes to the neighbour or a
+// fresh block, so sequential fills leave full blocks. A block that drops
+// below UNROLLED_MERGE values merges with a neighbour, or evens out with it
+// when the pair would nearly fill a block.
+// LIST_UNROLLED_BLOCK=n changes the block size.
+#ifdef LIST_UNROLLED_BLOCK
+    static const size_t UNROLLED_BLOCK = (size_t)LIST_UNROLLED_BLOCK;
+#else
+    static const size_t UNROLLED_BLOCK = 16;
+#endif
+static const size_t UNROLLED_MERGE = UNROLLED_BLOCK / 4 > 0 ? UNROLLED_BLOCK / 4 : 1;
+
+struct unrolled_block_t {
+    list_index_t next;
+    list_index_t prev;   // POISON for a free block, whose next links the free chain
+    uint32_t     count;
+    double       vals[UNROLLED_BLOCK];
+};
+
+struct list_unrolled_t {
+    unrolled_block_t* blocks;
+    size_t            capacity;   // blocks allocated
+    size_t            untouched;  // blocks [untouched, capacity) were never handed out
+    size_t            used;       // live blocks + the sentinel
+    size_t            size;       // values
+    ssize_t           free_head;
+};
+
+// capacity is in values; blocks are allocated for it up front
+error_code list_unrolled_init(list_unrolled_t* list, size_t capacity);
+error_code list_unrolled_dest(list_unrolled_t* list);
+
+// Positional operations: logical_index counts values from the front. Insert
+// puts val at logical_index (size appends); get/set/remove need an existing one.
+error_code list_unrolled_insert_at(list_unrolled_t* list, size_t logical_index, double val);
+error_code list_unrolled_remove_at(list_unrolled_t* list, size_t logical_index);
+error_code list_unrolled_get      (const list_unrolled_t* list, size_t logical_index, double* val_return);
+error_code list_unrolled_set      (list_unrolled_t* list, size_t logical_index, double val);
+
+error_code list_unrolled_push_back (list_unrolled_t* list, double val);
+error_code list_unrolled_push_front(list_unrolled_t* list, double val);
+error_code list_unrolled_pop_back  (list_unrolled_t* list);
+error_code list_unrolled_pop_front (list_unrolled_t* list);
+
+// Packs the values into full blocks laid out in logical order (slots 1..n)
+error_code list_unrolled_linearize    (list_unrolled_t* list);
+error_code list_unrolled_shrink_to_fit(list_unrolled_t* list, bool keep_growth);
+
+error_code list_unrolled_verify(const list_unrolled_t* list);
+
+static inline size_t list_unrolled_size(const list_unrolled_t* list) {
+    return list->size;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LIST_VALUE_INDEX_H_INCLUDED
+#define LIST_VALUE_INDEX_H_INCLUDED
+
+#include "list_info.h"
+#include "error_handler.h"
+#include <stdint.h>
+
+// Optional hash index from value to physical slot: open addressing with
+// linear probing and backward-shift deletion, one entry per live node (equal
+// values get one entry each). Values are compared by bit pattern, with -0.0
+// folded into 0.0.
+struct list_value_entry_t {
+    uint64_t     key;
+    list_index_t slot;  // -1 for an empty entry
+};
+
+struct list_value_index_t {
+    list_value_entry_t* entries;
+    size_t              capacity;  // power of two
+    size_t              count;
+};
+
+// Refused for pool lists
+error_code list_value_index_enable (list_t* list);
+void       list_value_index_disable(list_t* list);
+
+// Physical index of a node holding val, -1 if there is none. O(1) expected
+// with the index enabled, a walk of the chain without it.
+ssize_t    list_find        (const list_t* list, double val);
+bool       list_contains    (const list_t* list, double val);
+// Removes one node holding val; ERROR_MISSED_ELEM if there is none
+error_code list_remove_value(list_t* list, double val);
+
+//------------------------------------------------------------------------------
+// Maintenance entry points used by list_operations.cpp
+
+void       value_index_link   (list_t* list, ssize_t idx);
+void       value_index_unlink (list_t* list, ssize_t idx);
+void       value_index_swap   (list_t* list, ssize_t first_idx, ssize_t second_idx);
+void       value_index_rebuild(list_t* list);
+error_code value_index_verify (const list_t* list, const char** error_description);
+
+#endif
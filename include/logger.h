@@ -2,7 +2,9 @@
 #define LOGGER_H_INCLUDED
 
 #include <stdio.h>
+#ifndef LOGGER_DISABLE
 #define LOGGER_ALL
+#endif
 
 //==============================================================================
 
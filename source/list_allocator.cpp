@@ -0,0 +1,228 @@
+#include "list_allocator.h"
+#include "logger.h"
+#include "asserts.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t BLOCK_ALIGN        = 16;
+static const size_t DEFAULT_SLAB_BYTES = (size_t)1 << 20;
+static const size_t DEFAULT_POOL_SLAB  = 64;
+
+struct list_arena_slab_t {
+    list_arena_slab_t* prev;
+    size_t             capacity;
+    size_t             used;
+};
+
+//==============================================================================
+
+static size_t align_up(size_t bytes);
+static char*  slab_data(list_arena_slab_t* slab);
+static void*  arena_alloc  (void* ctx, size_t bytes);
+static void*  arena_realloc(void* ctx, void* block, size_t old_bytes, size_t new_bytes);
+static void   arena_free   (void* ctx, void* block, size_t bytes);
+static void*  pool_alloc   (void* ctx, size_t bytes);
+static void*  pool_realloc (void* ctx, void* block, size_t old_bytes, size_t new_bytes);
+static void   pool_free    (void* ctx, void* block, size_t bytes);
+
+//==============================================================================
+
+static size_t align_up(size_t bytes) {
+    return (bytes + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+}
+
+static char* slab_data(list_arena_slab_t* slab) {
+    return (char*)slab + align_up(sizeof(list_arena_slab_t));
+}
+
+//==============================================================================
+
+static void* arena_alloc(void* ctx, size_t bytes) {
+    list_arena_t* arena = (list_arena_t*)ctx;
+    size_t size = align_up(bytes);
+
+    list_arena_slab_t* slab = arena->top;
+    if (slab == nullptr || slab->capacity - slab->used < size) {
+        size_t capacity = size > arena->slab_bytes ? size : arena->slab_bytes;
+        LOGGER_DEBUG("Arena: new slab of %lu bytes", capacity);
+
+        slab = (list_arena_slab_t*)malloc(align_up(sizeof(list_arena_slab_t)) + capacity);
+        if (slab == nullptr) {
+            LOGGER_ERROR("Arena: malloc failed for slab");
+            return nullptr;
+        }
+        slab->prev     = arena->top;
+        slab->capacity = capacity;
+        slab->used     = 0;
+        arena->top     = slab;
+    }
+    void* block = slab_data(slab) + slab->used;
+    slab->used += size;
+    arena->last_block = block;
+    return block;
+}
+
+static void* arena_realloc(void* ctx, void* block, size_t old_bytes, size_t new_bytes) {
+    list_arena_t* arena = (list_arena_t*)ctx;
+    if (block == nullptr) {
+        return arena_alloc(ctx, new_bytes);
+    }
+
+    list_arena_slab_t* slab = arena->top;
+    if (block == arena->last_block) {
+        size_t base = slab->used - align_up(old_bytes);
+        if (slab->capacity - base >= align_up(new_bytes)) {
+            slab->used = base + align_up(new_bytes);
+            return block;
+        }
+    } else if (new_bytes <= old_bytes) {
+        return block;
+    }
+
+    void* new_block = arena_alloc(ctx, new_bytes);
+    if (new_block == nullptr) {
+        return nullptr;
+    }
+    memcpy(new_block, block, old_bytes < new_bytes ? old_bytes : new_bytes);
+    return new_block;
+}
+
+static void arena_free(void* ctx, void* block, size_t bytes) {
+    list_arena_t* arena = (list_arena_t*)ctx;
+    if (block != nullptr && block == arena->last_block) {
+        arena->top->used -= align_up(bytes);
+        arena->last_block = nullptr;
+    }
+}
+
+void list_arena_init(list_arena_t* arena, size_t slab_bytes) {
+    HARD_ASSERT(arena != nullptr, "arena is nullptr");
+
+    arena->top        = nullptr;
+    arena->slab_bytes = slab_bytes != 0 ? align_up(slab_bytes) : DEFAULT_SLAB_BYTES;
+    arena->last_block = nullptr;
+}
+
+// Keeps the oldest slab for the next round, everything else goes back
+void list_arena_reset(list_arena_t* arena) {
+    HARD_ASSERT(arena != nullptr, "arena is nullptr");
+
+    while (arena->top != nullptr && arena->top->prev != nullptr) {
+        list_arena_slab_t* prev = arena->top->prev;
+        free(arena->top);
+        arena->top = prev;
+    }
+    if (arena->top != nullptr) {
+        arena->top->used = 0;
+    }
+    arena->last_block = nullptr;
+}
+
+void list_arena_destroy(list_arena_t* arena) {
+    HARD_ASSERT(arena != nullptr, "arena is nullptr");
+
+    list_arena_reset(arena);
+    free(arena->top);
+    arena->top = nullptr;
+}
+
+list_allocator_t list_arena_allocator(list_arena_t* arena) {
+    HARD_ASSERT(arena != nullptr, "arena is nullptr");
+    return list_allocator_t{arena_alloc, arena_realloc, arena_free, arena};
+}
+
+//==============================================================================
+
+static void* pool_alloc(void* ctx, size_t bytes) {
+    list_pool_t* pool = (list_pool_t*)ctx;
+    if (bytes > pool->block_bytes) {
+        return malloc(bytes);
+    }
+
+    if (pool->free_blocks == nullptr) {
+        LOGGER_DEBUG("Pool: new slab of %lu blocks", pool->blocks_per_slab);
+        char* slab = (char*)malloc(BLOCK_ALIGN + pool->block_bytes * pool->blocks_per_slab);
+        if (slab == nullptr) {
+            LOGGER_ERROR("Pool: malloc failed for slab");
+            return nullptr;
+        }
+        *(void**)slab = pool->slabs;
+        pool->slabs   = slab;
+        for (size_t i = pool->blocks_per_slab; i > 0; --i) {
+            void* free_block   = slab + BLOCK_ALIGN + (i - 1) * pool->block_bytes;
+            *(void**)free_block = pool->free_blocks;
+            pool->free_blocks  = free_block;
+        }
+    }
+    void* block = pool->free_blocks;
+    pool->free_blocks = *(void**)block;
+    return block;
+}
+
+static void* pool_realloc(void* ctx, void* block, size_t old_bytes, size_t new_bytes) {
+    list_pool_t* pool = (list_pool_t*)ctx;
+    if (block == nullptr) {
+        return pool_alloc(ctx, new_bytes);
+    }
+
+    bool old_pooled = old_bytes <= pool->block_bytes;
+    bool new_pooled = new_bytes <= pool->block_bytes;
+    if (old_pooled && new_pooled) {
+        return block;
+    }
+    if (!old_pooled && !new_pooled) {
+        return realloc(block, new_bytes);
+    }
+
+    void* new_block = pool_alloc(ctx, new_bytes);
+    if (new_block == nullptr) {
+        return nullptr;
+    }
+    memcpy(new_block, block, old_bytes < new_bytes ? old_bytes : new_bytes);
+    pool_free(ctx, block, old_bytes);
+    return new_block;
+}
+
+static void pool_free(void* ctx, void* block, size_t bytes) {
+    list_pool_t* pool = (list_pool_t*)ctx;
+    if (block == nullptr) {
+        return;
+    }
+    if (bytes > pool->block_bytes) {
+        free(block);
+        return;
+    }
+    *(void**)block    = pool->free_blocks;
+    pool->free_blocks = block;
+}
+
+void list_pool_init(list_pool_t* pool, size_t block_bytes, size_t blocks_per_slab) {
+    HARD_ASSERT(pool != nullptr, "pool is nullptr");
+
+    if (block_bytes < sizeof(void*)) {
+        block_bytes = sizeof(void*);
+    }
+    pool->block_bytes     = align_up(block_bytes);
+    pool->blocks_per_slab = blocks_per_slab != 0 ? blocks_per_slab : DEFAULT_POOL_SLAB;
+    pool->free_blocks     = nullptr;
+    pool->slabs           = nullptr;
+}
+
+// Blocks still handed out become invalid; oversized (malloc'd) ones are the
+// owners' to free
+void list_pool_destroy(list_pool_t* pool) {
+    HARD_ASSERT(pool != nullptr, "pool is nullptr");
+
+    while (pool->slabs != nullptr) {
+        void* prev = *(void**)pool->slabs;
+        free(pool->slabs);
+        pool->slabs = prev;
+    }
+    pool->free_blocks = nullptr;
+}
+
+list_allocator_t list_pool_allocator(list_pool_t* pool) {
+    HARD_ASSERT(pool != nullptr, "pool is nullptr");
+    return list_allocator_t{pool_alloc, pool_realloc, pool_free, pool};
+}
@@ -0,0 +1,454 @@
+#include "list_bench.h"
+#include "list_info.h"
+#include "list_operations.h"
+#include "list_order_index.h"
+#include "list_value_index.h"
+#include "list_lru.h"
+#include "list_iterator.h"
+#include "list_template.h"
+#include "logger.h"
+#include "error_handler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+static const size_t DEFAULT_BENCH_SIZE = 1000000;
+static const int    WALK_REPEATS       = 5;
+static const int    POSITIONAL_OPS     = 16;
+static const int    INDEXED_OPS        = 200000;
+static const size_t LRU_OPS_PER_ENTRY  = 4;
+static const double LRU_KEY_SPREAD     = 1.25;  // key space / cache size: ~80% hits once warm
+static const size_t PREFETCH_DISTANCES[] = {0, 1, 2, 4, 8, 16, 32, 64};
+static const size_t PREFETCH_SWAP_SHARE = 16;   // partly linear list: one random swap per this many nodes
+static const size_t PAYLOAD_BYTES       = 256;
+static const size_t PAYLOAD_OPS         = 50;
+
+// A payload big enough that walking inline nodes strides over whole payloads
+struct bench_payload_t {
+    double val;
+    char   pad[PAYLOAD_BYTES - sizeof(double)];
+};
+
+//==============================================================================
+
+typedef error_code (*bench_handler_t)(size_t elem_count);
+
+static error_code bench_layout(size_t elem_count);
+static error_code bench_positional(size_t elem_count);
+static error_code bench_linearize(size_t elem_count);
+static error_code bench_lru(size_t elem_count);
+static error_code bench_prefetch(size_t elem_count);
+static error_code bench_payload(size_t elem_count);
+static bench_handler_t get_bench_handler(const char* name);
+
+//------------------------------------------------------------------------------
+
+static double   now_sec();
+static uint64_t rand_next(uint64_t* state);
+static const char* layout_name();
+static size_t      node_bytes();
+static error_code  build_list(list_t* list, size_t elem_count, bool fragmented);
+static void        report(const char* what, double seconds, size_t ops);
+static double      random_positional_ops(list_t* list, int ops, uint64_t seed);
+static double      lru_ops(list_lru_t* lru, size_t ops, size_t key_space, uint64_t seed, size_t* hits_return);
+static double      remove_push_ops(list_t* list, size_t max_entries, size_t ops, size_t key_space, uint64_t seed,
+                                   size_t* hits_return);
+static double      prefetch_walk(const list_t* list, size_t distance, list_prefetch_mode_t mode, double* sum_return);
+template <typename List>
+static double      payload_ops(size_t elem_count, size_t ops, error_code* error_return);
+
+//==============================================================================
+
+static double now_sec() {
+    timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rand_next(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static const char* layout_name() {
+#ifdef LIST_SOA
+    return "SoA";
+#else
+    return "AoS";
+#endif
+}
+
+static size_t node_bytes() {
+#ifdef LIST_SOA
+    return 2 * sizeof(list_index_t) + sizeof(double);
+#else
+    return sizeof(node_t);
+#endif
+}
+
+// Fragmented lists are built by inserting after a random live node, so that
+// physically consecutive slots end up far apart in logical order.
+static error_code build_list(list_t* list, size_t elem_count, bool fragmented) {
+    error_code error = list_init(list, elem_count + 2 ON_DEBUG(, VER_INIT));
+    if (error != ERROR_NO) return error;
+
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < elem_count; ++i) {
+        ssize_t after = 0;
+        if (fragmented && i > 0) {
+            after = (ssize_t)(rand_next(&seed) % i) + 1;
+        } else {
+            after = list->tail;
+        }
+        if (list_insert_after(list, after, (double)i) == -1) {
+            return ERROR_INSERT_FAIL;
+        }
+    }
+    return ERROR_NO;
+}
+
+static void report(const char* what, double seconds, size_t ops) {
+    printf("  %-28s %10.3f ms  %8.3f ns/op\n",
+           what, seconds * 1e3, seconds * 1e9 / (double)ops);
+}
+
+// Each op inserts at one random position and removes at another, so the
+// element count stays put and the list keeps getting more fragmented.
+static double random_positional_ops(list_t* list, int ops, uint64_t seed) {
+    double start = now_sec();
+    for (int op = 0; op < ops; ++op) {
+        ssize_t insert_pos = (ssize_t)(rand_next(&seed) % (list->size - 1));
+        list_insert_auto(list, insert_pos, -1.0);
+        ssize_t remove_pos = (ssize_t)(rand_next(&seed) % (list->size - 1));
+        list_remove_auto(list, remove_pos);
+    }
+    return now_sec() - start;
+}
+
+static double lru_ops(list_lru_t* lru, size_t ops, size_t key_space, uint64_t seed, size_t* hits_return) {
+    size_t hits = 0;
+    double start = now_sec();
+    for (size_t op = 0; op < ops; ++op) {
+        double key   = (double)(rand_next(&seed) % key_space);
+        double value = 0;
+        if (list_lru_get(lru, key, &value)) {
+            ++hits;
+        } else {
+            list_lru_put(lru, key, key, nullptr);
+        }
+    }
+    *hits_return = hits;
+    return now_sec() - start;
+}
+
+// The same access pattern with promotion done the old way: remove the node,
+// push a fresh one to the front
+static double remove_push_ops(list_t* list, size_t max_entries, size_t ops, size_t key_space, uint64_t seed,
+                              size_t* hits_return) {
+    size_t hits = 0;
+    double start = now_sec();
+    for (size_t op = 0; op < ops; ++op) {
+        double  key  = (double)(rand_next(&seed) % key_space);
+        ssize_t node = list_find(list, key);
+        if (node != -1) {
+            ++hits;
+            list_remove(list, node);
+        } else if (list->size - 1 >= max_entries) {
+            list_pop_back(list);
+        }
+        list_push_front(list, key);
+    }
+    *hits_return = hits;
+    return now_sec() - start;
+}
+
+static double prefetch_walk(const list_t* list, size_t distance, list_prefetch_mode_t mode, double* sum_return) {
+    double sum = 0;
+    double start = now_sec();
+    for (int rep = 0; rep < WALK_REPEATS; ++rep) {
+        for (double val : list_prefetch_range(list, distance, mode)) {
+            sum += val;
+        }
+    }
+    *sum_return += sum;
+    return now_sec() - start;
+}
+
+//==============================================================================
+
+static error_code bench_layout(size_t elem_count) {
+    printf("layout=%s node_bytes=%zu elements=%zu\n", layout_name(), node_bytes(), elem_count);
+
+    for (int fragmented = 0; fragmented <= 1; ++fragmented) {
+        list_t list = {};
+        error_code error = build_list(&list, elem_count, fragmented);
+        if (error != ERROR_NO) {
+            LOGGER_ERROR("bench_layout: failed to build list");
+            return error;
+        }
+        printf(" %s:\n", fragmented ? "fragmented" : "linear");
+
+        ssize_t checksum = 0;
+        double start = now_sec();
+        for (int rep = 0; rep < WALK_REPEATS; ++rep) {
+            for (ssize_t cur = list.head; cur != 0; cur = node_next(&list, cur)) {
+                checksum += cur;
+            }
+        }
+        report("walk next links", now_sec() - start, elem_count * WALK_REPEATS);
+
+        double sum = 0;
+        start = now_sec();
+        for (int rep = 0; rep < WALK_REPEATS; ++rep) {
+            for (ssize_t cur = list.head; cur != 0; cur = node_next(&list, cur)) {
+                sum += node_val(&list, cur);
+            }
+        }
+        report("walk + read values", now_sec() - start, elem_count * WALK_REPEATS);
+
+        double slot_sum = 0;
+        start = now_sec();
+        for (int rep = 0; rep < WALK_REPEATS; ++rep) {
+            for (size_t i = 1; i < list.capacity; ++i) {
+                if (!list_node_is_free(&list, (ssize_t)i)) slot_sum += node_val(&list, (ssize_t)i);
+            }
+        }
+        report("physical value scan", now_sec() - start, list.capacity * WALK_REPEATS);
+
+        uint64_t seed = 0xC0FFEEull;
+        start = now_sec();
+        for (int op = 0; op < POSITIONAL_OPS; ++op) {
+            ssize_t pos = (ssize_t)(rand_next(&seed) % (list.size - 1));
+            list_insert_auto(&list, pos, -1.0);
+            list_remove_auto(&list, pos + 1);
+        }
+        report("insert_auto+remove_auto", now_sec() - start, POSITIONAL_OPS);
+
+        printf("  (checksum %zd %g %g)\n", checksum, sum, slot_sum);
+        list_dest(&list);
+    }
+    return ERROR_NO;
+}
+
+static error_code bench_positional(size_t elem_count) {
+    printf("positional layout=%s elements=%zu\n", layout_name(), elem_count);
+
+    list_t list = {};
+    error_code error = build_list(&list, elem_count, true);
+    if (error != ERROR_NO) {
+        LOGGER_ERROR("bench_positional: failed to build list");
+        return error;
+    }
+
+    report("walk (no index)", random_positional_ops(&list, POSITIONAL_OPS, 0xC0FFEEull),
+           POSITIONAL_OPS);
+
+    double start = now_sec();
+    error = list_order_index_enable(&list);
+    if (error != ERROR_NO) {
+        list_dest(&list);
+        return error;
+    }
+    report("order index build", now_sec() - start, elem_count);
+    report("order index", random_positional_ops(&list, INDEXED_OPS, 0xBADC0DEull), INDEXED_OPS);
+
+    start = now_sec();
+    ssize_t checksum = 0;
+    for (ssize_t cur = list.head, i = 0; cur != 0 && i < INDEXED_OPS; cur = node_next(&list, cur), ++i) {
+        checksum += list_logical_index(&list, cur);
+    }
+    report("logical_index of head run", now_sec() - start, INDEXED_OPS);
+
+    printf("  (checksum %zd)\n", checksum);
+    list_dest(&list);
+    return ERROR_NO;
+}
+
+static error_code bench_linearize(size_t elem_count) {
+    printf("linearize layout=%s node_bytes=%zu elements=%zu\n", layout_name(), node_bytes(), elem_count);
+
+    for (int mode = 0; mode < 3; ++mode) {
+        list_t list = {};
+        error_code error = build_list(&list, elem_count, true);
+        if (error != ERROR_NO) {
+            LOGGER_ERROR("bench_linearize: failed to build list");
+            return error;
+        }
+        list_index_t* remap = nullptr;
+        if (mode == 2) {
+            remap = (list_index_t*)calloc(list.capacity, sizeof(list_index_t));
+            if (remap == nullptr) {
+                list_dest(&list);
+                return ERROR_MEM_ALLOC;
+            }
+        }
+
+        double start = now_sec();
+        if (mode == 0) {
+            error = list_linearize(&list);
+        } else {
+            error = list_linearize_copy(&list, remap);
+        }
+        double seconds = now_sec() - start;
+
+        const char* names[] = {"swap (in place)", "copy (scratch buffer)", "copy + remap table"};
+        report(names[mode], seconds, elem_count);
+        if (error != ERROR_NO || !list_is_linear(&list)) {
+            LOGGER_ERROR("bench_linearize: %s failed", names[mode]);
+        }
+        free(remap);
+        list_dest(&list);
+    }
+    return ERROR_NO;
+}
+
+static error_code bench_lru(size_t elem_count) {
+    const size_t ops       = elem_count * LRU_OPS_PER_ENTRY;
+    const size_t key_space = (size_t)((double)elem_count * LRU_KEY_SPREAD);
+    printf("lru layout=%s entries=%zu keys=%zu ops=%zu\n", layout_name(), elem_count, key_space, ops);
+
+    list_lru_t lru = {};
+    error_code error = list_lru_init(&lru, elem_count ON_DEBUG(, VER_INIT));
+    if (error != ERROR_NO) {
+        LOGGER_ERROR("bench_lru: failed to init cache");
+        return error;
+    }
+    size_t hits = 0;
+    lru_ops(&lru, ops, key_space, 0xC0FFEEull, &hits);  // warm-up fills the cache
+    double seconds = lru_ops(&lru, ops, key_space, 0xBADC0DEull, &hits);
+    report("get / put (move_to_front)", seconds, ops);
+    printf("  %-28s %10.2f Mops/s  hit rate %.1f%%\n", "", (double)ops / seconds * 1e-6,
+           100.0 * (double)hits / (double)ops);
+    list_lru_dest(&lru);
+
+    list_t list = {};
+    error = list_init(&list, elem_count + 2 ON_DEBUG(, VER_INIT));
+    if (error == ERROR_NO) error |= list_value_index_enable(&list);
+    if (error != ERROR_NO) {
+        LOGGER_ERROR("bench_lru: failed to init list");
+        return error;
+    }
+    remove_push_ops(&list, elem_count, ops, key_space, 0xC0FFEEull, &hits);
+    seconds = remove_push_ops(&list, elem_count, ops, key_space, 0xBADC0DEull, &hits);
+    report("remove + push_front", seconds, ops);
+    printf("  %-28s %10.2f Mops/s  hit rate %.1f%%\n", "", (double)ops / seconds * 1e-6,
+           100.0 * (double)hits / (double)ops);
+    list_dest(&list);
+    return ERROR_NO;
+}
+
+// Walk + read values with prefetching CHAIN and PHYSICAL modes over a range
+// of distances, on a fragmented list and on a linear one with a few swaps
+static error_code bench_prefetch(size_t elem_count) {
+    printf("prefetch layout=%s node_bytes=%zu elements=%zu\n", layout_name(), node_bytes(), elem_count);
+
+    for (int partly_linear = 0; partly_linear <= 1; ++partly_linear) {
+        list_t list = {};
+        error_code error = build_list(&list, elem_count, !partly_linear);
+        uint64_t seed = 0x5EEDull;
+        for (size_t i = 0; partly_linear && error == ERROR_NO && i < elem_count / PREFETCH_SWAP_SHARE; ++i) {
+            error = list_swap(&list, (ssize_t)(rand_next(&seed) % elem_count) + 1,
+                                     (ssize_t)(rand_next(&seed) % elem_count) + 1);
+        }
+        if (error != ERROR_NO) {
+            LOGGER_ERROR("bench_prefetch: failed to build list");
+            return error;
+        }
+        printf(" %s (locality %.2f):\n", partly_linear ? "partly linear" : "fragmented", list_locality(&list));
+
+        double sum = 0;
+        for (size_t distance : PREFETCH_DISTANCES) {
+            double chain    = prefetch_walk(&list, distance, LIST_PREFETCH_CHAIN,    &sum);
+            double physical = prefetch_walk(&list, distance, LIST_PREFETCH_PHYSICAL, &sum);
+            printf("  distance %-3zu chain %8.3f ns/node   physical %8.3f ns/node\n", distance,
+                   chain * 1e9 / (double)(elem_count * WALK_REPEATS),
+                   physical * 1e9 / (double)(elem_count * WALK_REPEATS));
+        }
+        printf("  (checksum %g)\n", sum);
+        list_dest(&list);
+    }
+    return ERROR_NO;
+}
+
+// remove_auto + insert_auto pairs at random positions of a scattered tlist_t
+// of bench_payload_t; the payload layout decides what the walks stride over
+template <typename List>
+static double payload_ops(size_t elem_count, size_t ops, error_code* error_return) {
+    List list = {};
+    error_code error = list_init(&list, elem_count + 1);
+    bench_payload_t payload = {};
+    for (size_t i = 0; error == ERROR_NO && i < elem_count; ++i) {
+        payload.val = (double)i;
+        if (list_push_back(&list, payload) == -1) error = ERROR_INSERT_FAIL;
+    }
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; error == ERROR_NO && i < elem_count; ++i) {
+        error = list_swap(&list, (ssize_t)(rand_next(&seed) % elem_count) + 1,
+                                 (ssize_t)(rand_next(&seed) % elem_count) + 1);
+    }
+
+    double start = now_sec();
+    for (size_t op = 0; error == ERROR_NO && op < ops; ++op) {
+        ssize_t pos = (ssize_t)(rand_next(&seed) % (list.size - 1));
+        error = list_remove_auto(&list, pos);
+        if (error == ERROR_NO && list_insert_auto(&list, pos, payload) == -1) error = ERROR_INSERT_FAIL;
+    }
+    double seconds = now_sec() - start;
+
+    list_dest(&list);
+    *error_return = error;
+    return seconds;
+}
+
+// tlist_t with PAYLOAD_BYTES payloads, inline vs in the arena
+static error_code bench_payload(size_t elem_count) {
+    typedef tlist_t<bench_payload_t, list_index_t, list_debug_off, list_payload_inline> inline_list_t;
+    typedef tlist_t<bench_payload_t, list_index_t, list_debug_off, list_payload_arena>  arena_list_t;
+    printf("payload payload_bytes=%zu elements=%zu ops=%zu\n", PAYLOAD_BYTES, elem_count, PAYLOAD_OPS);
+
+    error_code error = ERROR_NO;
+    double seconds = payload_ops<inline_list_t>(elem_count, PAYLOAD_OPS, &error);
+    if (error == ERROR_NO) {
+        printf(" inline (node_bytes=%zu):\n", sizeof(inline_list_t::node_type));
+        report("remove_auto + insert_auto", seconds, PAYLOAD_OPS);
+        seconds = payload_ops<arena_list_t>(elem_count, PAYLOAD_OPS, &error);
+    }
+    if (error != ERROR_NO) {
+        LOGGER_ERROR("bench_payload: list operation failed");
+        return error;
+    }
+    printf(" arena (node_bytes=%zu):\n", sizeof(arena_list_t::node_type));
+    report("remove_auto + insert_auto", seconds, PAYLOAD_OPS);
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+static bench_handler_t get_bench_handler(const char* name) {
+    if (strcmp(name, "layout")     == 0) return bench_layout;
+    if (strcmp(name, "positional") == 0) return bench_positional;
+    if (strcmp(name, "linearize")  == 0) return bench_linearize;
+    if (strcmp(name, "lru")        == 0) return bench_lru;
+    if (strcmp(name, "prefetch")   == 0) return bench_prefetch;
+    if (strcmp(name, "payload")    == 0) return bench_payload;
+    return NULL;
+}
+
+error_code list_run_benchmark(const char* name, size_t elem_count) {
+    bench_handler_t handler = get_bench_handler(name);
+    if (handler == NULL) {
+        LOGGER_ERROR("Unknown benchmark: %s", name);
+        return ERROR_INCORRECT_ARGS;
+    }
+    if (elem_count == 0) {
+        elem_count = DEFAULT_BENCH_SIZE;
+    }
+    return handler(elem_count);
+}
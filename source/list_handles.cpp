@@ -0,0 +1,333 @@
+#include "list_handles.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t MIN_ID_CAPACITY = 16;
+
+//==============================================================================
+
+static bool       resize_array(void** array, size_t count, size_t elem_size);
+static error_code reserve_ids(list_handle_table_t* table);
+static void       fill_unset(list_index_t* array, size_t from, size_t to);
+
+//==============================================================================
+
+static bool resize_array(void** array, size_t count, size_t elem_size) {
+    void* block = realloc(*array, count * elem_size);
+    if (block == nullptr) {
+        return false;
+    }
+    *array = block;
+    return true;
+}
+
+static void fill_unset(list_index_t* array, size_t from, size_t to) {
+    for (size_t i = from; i < to; ++i) {
+        array[i] = -1;
+    }
+}
+
+// Room for one more id
+static error_code reserve_ids(list_handle_table_t* table) {
+    if (table->id_count < table->id_capacity) {
+        return ERROR_NO;
+    }
+    size_t capacity = table->id_capacity < MIN_ID_CAPACITY ? MIN_ID_CAPACITY : table->id_capacity * 2;
+    bool ok = true;
+    ok &= resize_array((void**)&table->slot_of,    capacity, sizeof(list_index_t));
+    ok &= resize_array((void**)&table->generation, capacity, sizeof(uint32_t));
+    ok &= resize_array((void**)&table->free_ids,   capacity, sizeof(list_index_t));
+    if (!ok) {
+        LOGGER_ERROR("realloc failed for handle ids");
+        return ERROR_MEM_ALLOC;
+    }
+    table->id_capacity = capacity;
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+error_code list_handles_enable(list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Enabling handles");
+
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Handles are not available for lists in a node pool");
+        return ERROR_INCORRECT_ARGS;
+    }
+    if (list->handles != nullptr) {
+        return ERROR_NO;
+    }
+    list_handle_table_t* table = (list_handle_table_t*)calloc(1, sizeof(list_handle_table_t));
+    if (table == nullptr) {
+        LOGGER_ERROR("calloc failed for handle table");
+        return ERROR_MEM_ALLOC;
+    }
+    list->handles = table;
+
+    error_code error = handles_reserve(list, list->capacity);
+    if (error != ERROR_NO) {
+        list_handles_disable(list);
+    }
+    return error;
+}
+
+void list_handles_disable(list_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return;
+    }
+    LOGGER_DEBUG("Disabling handles");
+    free(table->id_of);
+    free(table->origin);
+    free(table->slot_of);
+    free(table->generation);
+    free(table->free_ids);
+    free(table);
+    list->handles = nullptr;
+}
+
+list_handle_t list_handle_of(list_t* list, ssize_t physical_index) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        LOGGER_ERROR("list_handle_of: handles are not enabled");
+        return LIST_HANDLE_NULL;
+    }
+    if (physical_index <= 0 || (size_t)physical_index >= list->capacity ||
+        list_node_is_free(list, physical_index)) {
+        LOGGER_ERROR("list_handle_of: %d is not a live node", physical_index);
+        return LIST_HANDLE_NULL;
+    }
+
+    list_index_t id = table->id_of[physical_index];
+    if (id == -1) {
+        if (table->free_count > 0) {
+            id = table->free_ids[--table->free_count];
+        } else {
+            if (reserve_ids(table) != ERROR_NO) {
+                return LIST_HANDLE_NULL;
+            }
+            id = as_index((ssize_t)table->id_count++);
+            table->generation[id] = 0;
+        }
+        table->slot_of[id]            = as_index(physical_index);
+        table->id_of[physical_index]  = id;
+    }
+    list_handle_t handle = {id, table->generation[id]};
+    return handle;
+}
+
+ssize_t list_handle_resolve(const list_t* list, list_handle_t handle) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    const list_handle_table_t* table = list->handles;
+    if (table == nullptr || handle.id < 0 || (size_t)handle.id >= table->id_count ||
+        table->generation[handle.id] != handle.generation) {
+        return -1;
+    }
+    return table->slot_of[handle.id];
+}
+
+error_code list_remap_begin(list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Recording node moves");
+
+    error_code error = list_handles_enable(list);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    list_handle_table_t* table = list->handles;
+    if (!resize_array((void**)&table->origin, table->capacity, sizeof(list_index_t))) {
+        LOGGER_ERROR("realloc failed for remap origins");
+        return ERROR_MEM_ALLOC;
+    }
+    for (size_t i = 0; i < table->capacity; ++i) {
+        bool live = i == 0 || (i < list->capacity && !list_node_is_free(list, (ssize_t)i));
+        table->origin[i] = live ? as_index((ssize_t)i) : -1;
+    }
+    table->origin_capacity = list->capacity;
+    return ERROR_NO;
+}
+
+error_code list_remap_end(list_t* list, list_index_t* remap) {
+    HARD_ASSERT(list != nullptr,  "list is nullptr");
+    HARD_ASSERT(remap != nullptr, "remap is nullptr");
+
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr || table->origin == nullptr) {
+        LOGGER_ERROR("list_remap_end without list_remap_begin");
+        return ERROR_INCORRECT_ARGS;
+    }
+    fill_unset(remap, 0, table->origin_capacity);
+    for (size_t i = 0; i < table->capacity; ++i) {
+        if (table->origin[i] != -1) {
+            remap[table->origin[i]] = as_index((ssize_t)i);
+        }
+    }
+    free(table->origin);
+    table->origin = nullptr;
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+error_code handles_reserve(list_t* list, size_t capacity) {
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return ERROR_NO;
+    }
+    LOGGER_DEBUG("Resizing handle table to %lu slots", capacity);
+
+    // Shrinks never fail in a way that matters: the old, bigger block is kept
+    bool ok = resize_array((void**)&table->id_of, capacity, sizeof(list_index_t));
+    if (table->origin != nullptr) {
+        ok &= resize_array((void**)&table->origin, capacity, sizeof(list_index_t));
+    }
+    if (!ok && capacity > table->capacity) {
+        LOGGER_ERROR("realloc failed for handle table");
+        return ERROR_MEM_ALLOC;
+    }
+    if (capacity > table->capacity) {
+        fill_unset(table->id_of, table->capacity, capacity);
+        if (table->origin != nullptr) {
+            fill_unset(table->origin, table->capacity, capacity);
+        }
+    }
+    table->capacity = capacity;
+    return ERROR_NO;
+}
+
+void handles_link(list_t* list, ssize_t idx) {
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr || table->origin == nullptr) {
+        return;
+    }
+    table->origin[idx] = -1;
+}
+
+void handles_unlink(list_t* list, ssize_t idx) {
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return;
+    }
+    list_index_t id = table->id_of[idx];
+    if (id != -1) {
+        table->slot_of[id] = -1;
+        table->generation[id]++;
+        table->free_ids[table->free_count++] = id;
+        table->id_of[idx] = -1;
+    }
+    if (table->origin != nullptr) {
+        table->origin[idx] = -1;
+    }
+}
+
+void handles_swap(list_t* list, ssize_t first_idx, ssize_t second_idx) {
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return;
+    }
+    list_index_t first_id  = table->id_of[first_idx];
+    list_index_t second_id = table->id_of[second_idx];
+    table->id_of[first_idx]  = second_id;
+    table->id_of[second_idx] = first_id;
+    if (first_id  != -1) table->slot_of[first_id]  = as_index(second_idx);
+    if (second_id != -1) table->slot_of[second_id] = as_index(first_idx);
+
+    if (table->origin != nullptr) {
+        list_index_t origin        = table->origin[first_idx];
+        table->origin[first_idx]   = table->origin[second_idx];
+        table->origin[second_idx]  = origin;
+    }
+}
+
+// Every node moved at once: old slot i now lives in remap[i] (-1 if free)
+error_code handles_relocate(list_t* list, const list_index_t* remap) {
+    list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return ERROR_NO;
+    }
+    list_index_t* id_of  = (list_index_t*)malloc(table->capacity * sizeof(list_index_t));
+    list_index_t* origin = nullptr;
+    if (table->origin != nullptr) {
+        origin = (list_index_t*)malloc(table->capacity * sizeof(list_index_t));
+    }
+    if (id_of == nullptr || (table->origin != nullptr && origin == nullptr)) {
+        LOGGER_ERROR("malloc failed while relocating handles");
+        free(id_of);
+        free(origin);
+        return ERROR_MEM_ALLOC;
+    }
+    fill_unset(id_of, 0, table->capacity);
+    if (origin != nullptr) {
+        fill_unset(origin, 0, table->capacity);
+    }
+
+    for (size_t i = 0; i < list->capacity; ++i) {
+        list_index_t to = remap[i];
+        if (to == -1) continue;
+        id_of[to] = table->id_of[i];
+        if (id_of[to] != -1) {
+            table->slot_of[id_of[to]] = to;
+        }
+        if (origin != nullptr) {
+            origin[to] = table->origin[i];
+        }
+    }
+    free(table->id_of);
+    free(table->origin);
+    table->id_of  = id_of;
+    table->origin = origin;
+    return ERROR_NO;
+}
+
+error_code handles_verify(const list_t* list, const char** error_description) {
+    const list_handle_table_t* table = list->handles;
+    if (table == nullptr) {
+        return ERROR_NO;
+    }
+    if (table->capacity < list->capacity) {
+        LOGGER_ERROR("handle table capacity %lu < list capacity %lu", table->capacity, list->capacity);
+        *error_description = "handle table too small";
+        return ERROR_INVALID_STRUCTURE;
+    }
+
+    size_t live_ids = 0;
+    for (size_t id = 0; id < table->id_count; ++id) {
+        ssize_t slot = table->slot_of[id];
+        if (slot == -1) continue;
+        ++live_ids;
+        if (slot <= 0 || (size_t)slot >= list->capacity || list_node_is_free(list, slot) ||
+            table->id_of[slot] != (list_index_t)id) {
+            LOGGER_ERROR("handle %lu points at slot %ld, which does not point back", id, slot);
+            *error_description = "handle table broken";
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    for (size_t i = 0; i < list->capacity; ++i) {
+        list_index_t id = table->id_of[i];
+        if (id != -1 && ((size_t)id >= table->id_count || table->slot_of[id] != (list_index_t)i)) {
+            LOGGER_ERROR("slot %lu holds handle %ld, which does not point back", i, (ssize_t)id);
+            *error_description = "handle table broken";
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    if (live_ids + table->free_count != table->id_count) {
+        LOGGER_ERROR("%lu live + %lu released handle ids != %lu", live_ids, table->free_count, table->id_count);
+        *error_description = "handle ids leaked";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    return ERROR_NO;
+}
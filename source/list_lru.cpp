@@ -0,0 +1,114 @@
+#include "list_lru.h"
+#include "list_info.h"
+#include "list_operations.h"
+#include "list_value_index.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+
+//==============================================================================
+
+static error_code reserve_payload(list_lru_t* lru);
+
+//==============================================================================
+
+// The list grows its capacity on its own; the payload array follows it
+static error_code reserve_payload(list_lru_t* lru) {
+    const size_t capacity = lru->list.capacity;
+    if (capacity <= lru->payload_capacity) {
+        return ERROR_NO;
+    }
+    double* payload = (double*)realloc(lru->payload, capacity * sizeof(double));
+    if (payload == nullptr) {
+        LOGGER_ERROR("realloc failed for LRU payload of %lu slots", capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    lru->payload          = payload;
+    lru->payload_capacity = capacity;
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+error_code list_lru_init(list_lru_t* lru, size_t max_entries ON_DEBUG(, ver_info_t ver_info)) {
+    HARD_ASSERT(lru != nullptr, "lru is nullptr");
+    LOGGER_DEBUG("Initialising LRU cache for %lu entries", max_entries);
+
+    if (max_entries == 0) {
+        LOGGER_ERROR("LRU cache needs room for at least one entry");
+        return ERROR_INCORRECT_ARGS;
+    }
+    *lru = {};
+    lru->max_entries = max_entries;
+
+    error_code error = list_init(&lru->list, max_entries + 2 ON_DEBUG(, ver_info));
+    if (error == ERROR_NO) error |= list_value_index_enable(&lru->list);
+    if (error == ERROR_NO) error |= reserve_payload(lru);
+    if (error != ERROR_NO) {
+        list_lru_dest(lru);
+    }
+    return error;
+}
+
+error_code list_lru_dest(list_lru_t* lru) {
+    HARD_ASSERT(lru != nullptr, "lru is nullptr");
+    LOGGER_DEBUG("Destroying LRU cache");
+
+    error_code error = ERROR_NO;
+    if (list_storage_ok(&lru->list)) {
+        error = list_dest(&lru->list);
+    }
+    free(lru->payload);
+    *lru = {};
+    return error;
+}
+
+bool list_lru_get(list_lru_t* lru, double key, double* value_return) {
+    HARD_ASSERT(lru != nullptr,          "lru is nullptr");
+    HARD_ASSERT(value_return != nullptr, "value_return is nullptr");
+
+    ssize_t node = list_find(&lru->list, key);
+    if (node == -1) {
+        return false;
+    }
+    list_move_to_front(&lru->list, node);
+    *value_return = lru->payload[node];
+    return true;
+}
+
+error_code list_lru_put(list_lru_t* lru, double key, double value, bool* evicted_return) {
+    HARD_ASSERT(lru != nullptr, "lru is nullptr");
+
+    if (evicted_return != nullptr) {
+        *evicted_return = false;
+    }
+    ssize_t node = list_find(&lru->list, key);
+    if (node != -1) {
+        lru->payload[node] = value;
+        return list_move_to_front(&lru->list, node);
+    }
+
+    if (list_lru_size(lru) >= lru->max_entries) {
+        LOGGER_DEBUG("LRU cache full, evicting %lf", node_val(&lru->list, lru->list.tail));
+        error_code error = list_pop_back(&lru->list);
+        if (error != ERROR_NO) {
+            return error;
+        }
+        if (evicted_return != nullptr) {
+            *evicted_return = true;
+        }
+    }
+    node = list_push_front(&lru->list, key);
+    if (node == -1) {
+        return ERROR_INSERT_FAIL;
+    }
+    error_code error = reserve_payload(lru);
+    if (error != ERROR_NO) {
+        list_remove(&lru->list, node);
+        return error;
+    }
+    lru->payload[node] = value;
+    return ERROR_NO;
+}
@@ -3,6 +3,10 @@
 #include "asserts.h"
 #include "error_handler.h"
 #include "list_operations.h"
+#include "list_storage.h"
+#include "list_order_index.h"
+#include "list_handles.h"
+#include "list_value_index.h"
 #include <cstdlib>
 #include <cstring>
 
@@ -10,29 +14,420 @@
 
 //==============================================================================
 
-static void init_free_list(list_t* list, size_t start_index, size_t end_index) ;
+static ssize_t take_free_slot(list_t* list);
+static inline void adjust_size(list_t* list, ssize_t delta);
 static error_code list_recalloc(list_t* list, size_t new_capacity) ; 
 static error_code normalize_capacity(list_t* list);
+static error_code reserve_for(list_t* list, size_t extra);
+static ssize_t chain_slot(list_t* list, ssize_t prev_index, bool contiguous, double val);
+static void unlink_range(list_t* list, ssize_t first_idx, ssize_t last_idx);
+static void link_range(list_t* list, ssize_t after_idx, ssize_t first_idx, ssize_t last_idx);
+static void free_range(list_t* list, ssize_t first_idx, ssize_t last_idx);
+static bool range_args_ok(const list_t* list, ssize_t first_idx, ssize_t last_idx);
+static ssize_t range_length(const list_t* list, ssize_t first_idx, ssize_t last_idx);
+static bool run_excludes(const list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t outside_idx);
+static bool splice_args_ok(const list_t* dest, ssize_t dest_after, const list_t* src, ssize_t first_idx,
+                           ssize_t last_idx);
+static void move_run(list_t* list, ssize_t dest_after, ssize_t first_idx, ssize_t last_idx);
+static bool pool_owns(const list_t* list, ssize_t idx);
 static error_code list_reorganize_free(list_t* list);
+static inline void poison_node(list_t* list, ssize_t idx);
+static ssize_t resolve_logical(const list_t* list, ssize_t logical);
+static inline void set_finger(list_t* list, ssize_t logical, ssize_t physical);
+static inline ssize_t swapped_index(ssize_t idx, ssize_t first_idx, ssize_t second_idx);
+static void swap_slots(list_t* list, ssize_t first_idx, ssize_t second_idx, bool keep_free_chain);
+static void replace_free_slot(list_t* list, ssize_t new_idx, list_index_t free_prev, list_index_t free_next);
+static void push_free_slot(list_t* list, ssize_t idx);
+static size_t shrink_target(const list_t* list);
+static error_code compact_below(list_t* list, size_t target);
+static error_code maybe_shrink(list_t* list);
+static void compact_nodes(list_t* list, size_t budget, ssize_t* follow);
+static error_code maybe_relayout(list_t* list, size_t mutations, ssize_t* follow);
+//------------------------------------------------------------------------------
+static void prefix_on_link  (list_t* list, ssize_t after_idx, ssize_t idx);
+static void on_node_linked  (list_t* list, ssize_t after_idx, ssize_t idx);
+static void on_run_linked   (list_t* list, ssize_t after_idx, ssize_t first_idx, size_t count);
+static void prefix_on_cut   (list_t* list, ssize_t idx);
+static void on_range_unlinked(list_t* list, ssize_t first_idx, ssize_t last_idx);
+static void on_range_moved  (list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t after_idx,
+                             ssize_t old_last_next, ssize_t old_after_next);
+static void on_node_unlinked(list_t* list, ssize_t idx);
+static void on_nodes_swapped(list_t* list, ssize_t first_idx, ssize_t second_idx, size_t seq_before);
+static void on_relayout     (list_t* list);
+static inline size_t is_seq (ssize_t from_idx, ssize_t to_idx);
+static size_t slot_seq_links(const list_t* list, ssize_t first_idx, ssize_t second_idx);
+static void on_capacity_changed(list_t* list);
 
 //==============================================================================
 
-static void init_free_list(list_t* list, size_t start_index, size_t end_index) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
-    for (size_t i = start_index; i + 1 < end_index; ++i) {
-        list->arr[i].next = i + 1;
-        list->arr[i].prev = -1;
-        list->arr[i].val  = POISON;
+static inline void poison_node(list_t* list, ssize_t idx) {
+    node_val (list, idx) = POISON;
+    node_prev(list, idx) = -1;
+    node_next(list, idx) = -1;
+}
+
+// A list inside a node pool also counts its slots against the pool
+static inline void adjust_size(list_t* list, ssize_t delta) {
+    list->size += (size_t)delta;
+    if (list->pool != nullptr) {
+        list->pool->store.size += (size_t)delta;
+    }
+}
+
+//==============================================================================
+
+// Hooks every mutation reports to, keeping derived per-list state in sync.
+// linear_prefix: logical [0, linear_prefix) live in physical [1, linear_prefix].
+// seq_links: links a -> a + 1, the sentinel's link to head included.
+// finger: survives links after it and unlinks of itself or past it; any
+// other change of the order before it drops it.
+
+static inline size_t is_seq(ssize_t from_idx, ssize_t to_idx) {
+    return to_idx == from_idx + 1 ? 1 : 0;
+}
+
+// Sequential links into and out of two live slots, each link counted once
+static size_t slot_seq_links(const list_t* list, ssize_t first_idx, ssize_t second_idx) {
+    const ssize_t ids[2] = {first_idx, second_idx};
+    size_t count = 0;
+    for (int k = 0; k < 2; ++k) {
+        if (list_node_is_free(list, ids[k])) continue;
+        ssize_t next_index = node_next(list, ids[k]);
+        count += is_seq(node_prev(list, ids[k]), ids[k]);
+        if (next_index != ids[1 - k] || list_node_is_free(list, next_index)) {
+            count += is_seq(ids[k], next_index);
+        }
+    }
+    return count;
+}
+
+static void prefix_on_link(list_t* list, ssize_t after_idx, ssize_t idx) {
+    size_t prefix = list->linear_prefix;
+    size_t pos    = 0;
+    if (after_idx == 0) {
+        pos = 0;
+    } else if ((size_t)after_idx <= prefix) {
+        pos = (size_t)after_idx;
+    } else {
+        return;
+    }
+
+    if (pos < prefix) {
+        list->linear_prefix = pos;
+    } else if ((size_t)idx == prefix + 1) {
+        list->linear_prefix = prefix + 1;
+    }
+}
+
+static void on_node_linked(list_t* list, ssize_t after_idx, ssize_t idx) {
+    order_index_insert_after(list, after_idx, idx);
+    prefix_on_link(list, after_idx, idx);
+
+    handles_link(list, idx);
+    value_index_link(list, idx);
+
+    ssize_t next_index = node_next(list, idx);
+    if (after_idx != list->finger_physical && next_index != 0) {
+        list->finger_physical = 0;
+    }
+    list->seq_links += is_seq(after_idx, idx) + is_seq(idx, next_index);
+    list->seq_links -= is_seq(after_idx, next_index);
+}
+
+// count nodes starting at first_idx were linked one after another
+static void on_run_linked(list_t* list, ssize_t after_idx, ssize_t first_idx, size_t count) {
+    order_index_insert_run(list, after_idx, first_idx, count);
+    const ssize_t run_after = after_idx;
+    ssize_t cur = first_idx;
+    for (; count > 0; --count) {
+        prefix_on_link(list, after_idx, cur);
+        handles_link(list, cur);
+        value_index_link(list, cur);
+        list->seq_links += is_seq(after_idx, cur);
+        after_idx = cur;
+        cur       = node_next(list, cur);
+    }
+    list->seq_links += is_seq(after_idx, cur);
+    list->seq_links -= is_seq(run_after, cur);
+    if (run_after != list->finger_physical && cur != 0) {
+        list->finger_physical = 0;
+    }
+}
+
+// idx got a new predecessor: the prefix cannot reach past it any more
+static void prefix_on_cut(list_t* list, ssize_t idx) {
+    if (idx != 0 && (size_t)idx <= list->linear_prefix) {
+        list->linear_prefix = (size_t)idx - 1;
+    }
+}
+
+// Called before first..last are unlinked, while the order index still holds them
+static void on_range_unlinked(list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    order_index_remove_range(list, first_idx, last_idx);
+    prefix_on_cut(list, first_idx);
+    list->finger_physical = 0;
+
+    ssize_t prev_index = node_prev(list, first_idx);
+    ssize_t next_index = node_next(list, last_idx);
+    size_t  lost       = is_seq(prev_index, first_idx) + is_seq(last_idx, next_index);
+    for (ssize_t cur = first_idx; cur != last_idx; cur = node_next(list, cur)) {
+        lost += is_seq(cur, node_next(list, cur));
+        handles_unlink(list, cur);
+        value_index_unlink(list, cur);
+    }
+    handles_unlink(list, last_idx);
+    value_index_unlink(list, last_idx);
+    list->seq_links += is_seq(prev_index, next_index);
+    list->seq_links -= lost;
+}
+
+static void on_range_moved(list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t after_idx,
+                           ssize_t old_last_next, ssize_t old_after_next) {
+    order_index_move_range(list, first_idx, last_idx, after_idx);
+    prefix_on_cut(list, first_idx);
+    prefix_on_cut(list, old_last_next);
+    prefix_on_cut(list, old_after_next);
+    list->finger_physical = 0;
+
+    // Called before the relink: the run's inner links stay as they are
+    ssize_t prev_index = node_prev(list, first_idx);
+    list->seq_links += is_seq(prev_index, old_last_next) + is_seq(after_idx, first_idx) +
+                       is_seq(last_idx, old_after_next);
+    list->seq_links -= is_seq(prev_index, first_idx) + is_seq(last_idx, old_last_next) +
+                       is_seq(after_idx, old_after_next);
+}
+
+// Called once the neighbours skip idx, while idx still holds its own links
+static void on_node_unlinked(list_t* list, ssize_t idx) {
+    order_index_remove(list, idx);
+    handles_unlink(list, idx);
+    value_index_unlink(list, idx);
+    if ((size_t)idx <= list->linear_prefix) {
+        list->linear_prefix = (size_t)idx - 1;
+    }
+
+    ssize_t prev_index = node_prev(list, idx);
+    ssize_t next_index = node_next(list, idx);
+    list->seq_links += is_seq(prev_index, next_index);
+    list->seq_links -= is_seq(prev_index, idx) + is_seq(idx, next_index);
+
+    if (idx == list->finger_physical) {
+        set_finger(list, list->finger_logical - 1, prev_index);
+    } else if (next_index != 0) {
+        list->finger_physical = 0;
     }
-    list->arr[end_index - 1].next = -1;
-    list->arr[end_index - 1].prev = -1;
-    list->arr[end_index - 1].val  = POISON;
+}
+
+// seq_before: slot_seq_links of the two slots before the swap
+static void on_nodes_swapped(list_t* list, ssize_t first_idx, ssize_t second_idx, size_t seq_before) {
+    order_index_swap(list, first_idx, second_idx);
+    handles_swap(list, first_idx, second_idx);
+    value_index_swap(list, first_idx, second_idx);
+    ssize_t low = first_idx < second_idx ? first_idx : second_idx;
+    if ((size_t)low <= list->linear_prefix) {
+        list->linear_prefix = (size_t)low - 1;
+    }
+    list->seq_links += slot_seq_links(list, first_idx, second_idx);
+    list->seq_links -= seq_before;
+    list->finger_physical = swapped_index(list->finger_physical, first_idx, second_idx);
+}
+
+static void on_relayout(list_t* list) {
+    list->linear_prefix = list->size - 1;
+    list->seq_links     = list->size - 1;
+    list->mutations     = 0;
+    if (list->finger_physical != 0) {
+        list->finger_physical = list->finger_logical + 1;
+    }
+    order_index_invalidate(list);
+}
+
+// Auxiliary per-slot arrays follow the node storage; one that cannot grow is
+// dropped rather than failing the list operation that triggered the growth.
+static void on_capacity_changed(list_t* list) {
+    if (order_index_reserve(list, list->capacity) != ERROR_NO) {
+        LOGGER_ERROR("Order index could not follow capacity %lu, disabling it", list->capacity);
+        list_order_index_disable(list);
+    }
+    if (handles_reserve(list, list->capacity) != ERROR_NO) {
+        LOGGER_ERROR("Handle table could not follow capacity %lu, disabling it", list->capacity);
+        list_handles_disable(list);
+    }
+}
+
+//==============================================================================
+
+// Logical index -> physical slot. Inside the linear prefix the answer is
+// direct, past it the order index answers in O(log n) if enabled. Otherwise
+// the walk starts from whichever of the prefix end, the finger and the tail
+// is nearest, so neighbouring lookups cost O(distance).
+static ssize_t resolve_logical(const list_t* list, ssize_t logical) {
+    size_t prefix = list->linear_prefix;
+    if ((size_t)logical < prefix) {
+        return logical + 1;
+    }
+    if (list->order_index != nullptr) {
+        return order_index_select(list, logical);
+    }
+
+    ssize_t physical = list->head;
+    ssize_t i        = 0;
+    if (prefix > 0) {
+        physical = (ssize_t)prefix;
+        i        = (ssize_t)prefix - 1;
+    }
+    const ssize_t last = (ssize_t)list->size - 2;
+    if (logical <= last) {
+        ssize_t distance = logical - i;
+        if (last - logical < distance) {
+            physical = list->tail;
+            i        = last;
+            distance = last - logical;
+        }
+        ssize_t finger_distance = logical - list->finger_logical;
+        if (finger_distance < 0) finger_distance = -finger_distance;
+        if (list->finger_physical != 0 && finger_distance < distance) {
+            physical = list->finger_physical;
+            i        = list->finger_logical;
+        }
+        for (; i > logical; --i) {
+            physical = node_prev(list, physical);
+        }
+    }
+    for (; i < logical; ++i) {
+        physical = node_next(list, physical);
+    }
+    return physical;
+}
+
+static inline void set_finger(list_t* list, ssize_t logical, ssize_t physical) {
+    if (logical < 0 || (size_t)logical + 1 >= list->size || physical <= 0) {
+        list->finger_physical = 0;
+        return;
+    }
+    list->finger_logical  = logical;
+    list->finger_physical = physical;
+}
+
+static inline ssize_t swapped_index(ssize_t idx, ssize_t first_idx, ssize_t second_idx) {
+    if (idx == first_idx)  return second_idx;
+    if (idx == second_idx) return first_idx;
+    return idx;
+}
+
+// The free chain is doubly linked (prev is -1 at its head), so a slot can
+// leave it from anywhere in O(1).
+static void push_free_slot(list_t* list, ssize_t idx) {
+    list_t* store = list_store(list);
+    node_next(list, idx) = as_index(store->free_head);
+    node_prev(list, idx) = -1;
+    node_val (list, idx) = POISON;
+    if (store->free_head != -1) {
+        node_prev(list, store->free_head) = as_index(idx);
+    }
+    store->free_head = idx;
+}
+
+// new_idx takes over the free chain place between free_prev and free_next
+static void replace_free_slot(list_t* list, ssize_t new_idx, list_index_t free_prev, list_index_t free_next) {
+    list_t* store = list_store(list);
+    if (free_prev == -1) {
+        store->free_head = new_idx;
+    } else {
+        node_next(list, free_prev) = as_index(new_idx);
+    }
+    if (free_next != -1) {
+        node_prev(list, free_next) = as_index(new_idx);
+    }
+    poison_node(list, new_idx);
+    node_next(list, new_idx) = free_next;
+    node_prev(list, new_idx) = free_prev;
+}
+
+// Exchanges the contents of two slots and relinks their neighbours, adjacent
+// nodes included. A live node swapped with a free slot moves into it; the
+// free chain is patched only if keep_free_chain is set (linearize rebuilds it).
+static void swap_slots(list_t* list, ssize_t first_idx, ssize_t second_idx, bool keep_free_chain) {
+    bool first_free  = list_node_is_free(list, first_idx);
+    bool second_free = list_node_is_free(list, second_idx);
+    if (first_idx == second_idx || (first_free && second_free)) {
+        return;
+    }
+    const size_t seq_before = slot_seq_links(list, first_idx, second_idx);
+    if (first_free) {
+        ssize_t tmp = first_idx;
+        first_idx   = second_idx;
+        second_idx  = tmp;
+        second_free = true;
+    }
+
+    if (second_free) {
+        ssize_t next_index = node_next(list, first_idx);
+        ssize_t prev_index = node_prev(list, first_idx);
+        double  val        = node_val (list, first_idx);
+        list_index_t free_next = node_next(list, second_idx);
+        list_index_t free_prev = node_prev(list, second_idx);
+
+        node_next(list, second_idx) = as_index(next_index);
+        node_prev(list, second_idx) = as_index(prev_index);
+        node_val (list, second_idx) = val;
+        node_prev(list, next_index) = as_index(second_idx);
+        node_next(list, prev_index) = as_index(second_idx);
+
+        if (keep_free_chain) {
+            replace_free_slot(list, first_idx, free_prev, free_next);
+        } else {
+            poison_node(list, first_idx);
+        }
+    } else {
+        ssize_t first_next  = swapped_index(node_next(list, first_idx),  first_idx, second_idx);
+        ssize_t first_prev  = swapped_index(node_prev(list, first_idx),  first_idx, second_idx);
+        ssize_t second_next = swapped_index(node_next(list, second_idx), first_idx, second_idx);
+        ssize_t second_prev = swapped_index(node_prev(list, second_idx), first_idx, second_idx);
+        double  first_val   = node_val(list, first_idx);
+
+        node_next(list, first_idx)  = as_index(second_next);
+        node_prev(list, first_idx)  = as_index(second_prev);
+        node_val (list, first_idx)  = node_val(list, second_idx);
+        node_next(list, second_idx) = as_index(first_next);
+        node_prev(list, second_idx) = as_index(first_prev);
+        node_val (list, second_idx) = first_val;
+
+        node_prev(list, first_next)  = as_index(second_idx);
+        node_next(list, first_prev)  = as_index(second_idx);
+        node_prev(list, second_next) = as_index(first_idx);
+        node_next(list, second_prev) = as_index(first_idx);
+    }
+
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+    on_nodes_swapped(list, first_idx, second_idx, seq_before);
+}
+
+// Recycled slots come first; otherwise the next never-used slot is bumped off
+// the untouched tail, so fresh memory is only written when it is handed out.
+static ssize_t take_free_slot(list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    list = list_store(list);
+    ssize_t free_index = list->free_head;
+    if (free_index != -1) {
+        list->free_head = node_next(list, free_index);
+        if (list->free_head != -1) {
+            node_prev(list, list->free_head) = -1;
+        }
+        return free_index;
+    }
+    if (list->untouched < list->capacity) {
+        return (ssize_t)list->untouched++;
+    }
+    return -1;
 }
 
 static error_code list_recalloc(list_t* list, size_t new_capacity) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
 
     error_code error = 0;
     ON_DEBUG(
@@ -44,36 +439,18 @@ static error_code list_recalloc(list_t* list, size_t new_capacity) {
         LOGGER_WARNING("Attempting to realloc to zero capacity");
     }
 
-    size_t alloc_count = new_capacity ON_DEBUG(+ 1);
-    size_t new_bytes   = alloc_count * sizeof(node_t);
-    LOGGER_DEBUG("Reallocating %lu bytes for list", new_bytes);
-
-    node_t* new_block = (node_t*)(realloc(list->arr, new_bytes));
-    if (new_block == nullptr) {
-        LOGGER_ERROR("Realloc failed");
-        return ERROR_MEM_ALLOC;
+    error = list_storage_resize(list, new_capacity);
+    if (error != ERROR_NO) {
+        return error;
     }
-    list->arr = new_block;
-    new_block[0].val = CANARY_NUM;
+    node_val(list, 0) = CANARY_NUM;
     ON_DEBUG(
-        new_block[new_capacity].val = CANARY_NUM;
+        node_val(list, new_capacity) = CANARY_NUM;
     )
 
-    size_t old_capacity = list->capacity;
-    if (list->free_head == -1) {
-        list->free_head = old_capacity;
-        init_free_list(list, old_capacity, new_capacity);
-    } else {
-        ssize_t last_free = list->free_head;
-        while (last_free != -1 && list->arr[last_free].next != -1) {
-            last_free = list->arr[last_free].next;
-        }
-        if (last_free != -1) {
-            list->arr[last_free].next = old_capacity;
-        }
-        init_free_list(list, old_capacity, new_capacity);
-    }
+    // New slots simply extend the untouched tail, nothing to initialise here
     list->capacity = new_capacity;
+    on_capacity_changed(list);
 
     ON_DEBUG(
         error |= list_verify(list, VER_INIT, DUMP_IMG, "After recalloc to %lu", new_capacity);
@@ -82,91 +459,310 @@ static error_code list_recalloc(list_t* list, size_t new_capacity) {
 }
 
 static error_code normalize_capacity(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr  is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr  is nullptr");
+    list = list_store(list);
     LOGGER_DEBUG("Normalising capacity (size: %lu, capacity: %lu)",
                  list->size, list->capacity);
 
     if (list->size + 1 > list->capacity) {
-        size_t new_capacity = (size_t)((double)list->capacity * GROWTH_FACTOR);
+        if (list->capacity >= LIST_MAX_CAPACITY) {
+            LOGGER_ERROR("List reached max capacity %lu", LIST_MAX_CAPACITY);
+            return ERROR_BIG_SIZE;
+        }
+        size_t new_capacity = list_storage_grow_capacity(list);
+        if (new_capacity > LIST_MAX_CAPACITY) {
+            new_capacity = LIST_MAX_CAPACITY;
+        }
         LOGGER_DEBUG("Growing list to capacity %lu", new_capacity);
         return list_recalloc(list, new_capacity);
     }
     return ERROR_NO;
 }
 
+// Grows once so that `extra` more nodes fit and normalize_capacity's spare
+// slot is still there afterwards.
+static error_code reserve_for(list_t* list, size_t extra) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr  is nullptr");
+
+    list = list_store(list);
+    if (extra > LIST_MAX_CAPACITY - list->size - 1) {
+        LOGGER_ERROR("Cannot reserve %lu more nodes (max capacity %lu)", extra, LIST_MAX_CAPACITY);
+        return ERROR_BIG_SIZE;
+    }
+    size_t needed = list->size + extra + 1;
+    if (needed <= list->capacity) {
+        return ERROR_NO;
+    }
+    size_t new_capacity = list_storage_grow_capacity(list);
+    if (new_capacity < needed || new_capacity > LIST_MAX_CAPACITY) {
+        new_capacity = list_storage_fit_capacity(list, needed);
+    }
+    LOGGER_DEBUG("Reserving capacity %lu for %lu more nodes", new_capacity, extra);
+    return list_recalloc(list, new_capacity);
+}
+
+// Takes a reserved slot for the node following prev_index in a run being
+// linked; the caller closes the run with the final next link.
+static ssize_t chain_slot(list_t* list, ssize_t prev_index, bool contiguous, double val) {
+    ssize_t free_index = contiguous ? (ssize_t)list_store(list)->untouched++ : take_free_slot(list);
+    HARD_ASSERT(free_index != -1, "reserved slot missing");
+
+    node_val (list, free_index) = val;
+    node_prev(list, free_index) = as_index(prev_index);
+    node_next(list, prev_index) = as_index(free_index);
+    return free_index;
+}
+
+static void unlink_range(list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    ssize_t prev_index = node_prev(list, first_idx);
+    ssize_t next_index = node_next(list, last_idx);
+    node_next(list, prev_index) = as_index(next_index);
+    node_prev(list, next_index) = as_index(prev_index);
+}
+
+static void link_range(list_t* list, ssize_t after_idx, ssize_t first_idx, ssize_t last_idx) {
+    ssize_t next_index = node_next(list, after_idx);
+    node_next(list, after_idx)  = as_index(first_idx);
+    node_prev(list, first_idx)  = as_index(after_idx);
+    node_next(list, last_idx)   = as_index(next_index);
+    node_prev(list, next_index) = as_index(last_idx);
+}
+
+// Pushed back to front, so that the free chain hands the slots out in their
+// old logical order again.
+static void free_range(list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    ssize_t cur = last_idx;
+    while (true) {
+        ssize_t prev_index = node_prev(list, cur);
+        push_free_slot(list, cur);
+        if (cur == first_idx) break;
+        cur = prev_index;
+    }
+}
+
+// Number of nodes in first..last, -1 if last does not follow first
+static ssize_t range_length(const list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    ssize_t length = 1;
+    for (ssize_t cur = first_idx; cur != last_idx; cur = node_next(list, cur)) {
+        if (cur == 0 || (size_t)length >= list->size) {
+            return -1;
+        }
+        length++;
+    }
+    return length;
+}
+
+// Like range_length, but only checks: last follows first and outside_idx is
+// not in first..last
+static bool run_excludes(const list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t outside_idx) {
+    size_t length = 1;
+    for (ssize_t cur = first_idx; ; cur = node_next(list, cur), ++length) {
+        if (cur == outside_idx || cur == 0 || length >= list->size) {
+            return false;
+        }
+        if (cur == last_idx) return true;
+    }
+}
+
+static bool splice_args_ok(const list_t* dest, ssize_t dest_after, const list_t* src, ssize_t first_idx,
+                           ssize_t last_idx) {
+    return dest_after >= 0 && (size_t)dest_after < list_store(dest)->untouched &&
+           !list_node_is_free(dest, dest_after) && range_args_ok(src, first_idx, last_idx);
+}
+
+// The lists of a node pool share slots, so a live slot may be a sibling's.
+// Every chain ends in link 0, but only this list's ends at its tail: walks
+// from idx to the end, O(distance). Always true without a pool.
+static bool pool_owns(const list_t* list, ssize_t idx) {
+    if (list->pool == nullptr || idx == 0) {
+        return true;
+    }
+    size_t steps = 1;
+    for (ssize_t next = node_next(list, idx); next != 0; idx = next, next = node_next(list, idx)) {
+        if (++steps >= list->size) return false;
+    }
+    return idx == list->tail;
+}
+
+// Relinks the checked run first..last of list after dest_after in O(1)
+static void move_run(list_t* list, ssize_t dest_after, ssize_t first_idx, ssize_t last_idx) {
+    ssize_t old_last_next  = node_next(list, last_idx);
+    ssize_t old_after_next = node_next(list, dest_after);
+    if (dest_after == node_prev(list, first_idx)) {
+        return;
+    }
+    on_range_moved(list, first_idx, last_idx, dest_after, old_last_next, old_after_next);
+    unlink_range(list, first_idx, last_idx);
+    link_range(list, dest_after, first_idx, last_idx);
+
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+}
+
 //==============================================================================
 
 error_code list_init(list_t* list_return, size_t capacity ON_DEBUG(, ver_info_t ver_info)) {
+    return list_init_storage(list_return, capacity, LIST_STORAGE_FLAT ON_DEBUG(, ver_info));
+}
+
+error_code list_init_storage(list_t* list_return, size_t capacity, list_storage_kind_t storage_kind
+                             ON_DEBUG(, ver_info_t ver_info)) {
+    return list_init_with_allocator(list_return, capacity, storage_kind, nullptr ON_DEBUG(, ver_info));
+}
+
+error_code list_init_with_allocator(list_t* list_return, size_t capacity, list_storage_kind_t storage_kind,
+                                    const list_allocator_t* allocator ON_DEBUG(, ver_info_t ver_info)) {
     HARD_ASSERT(list_return != nullptr, "list_return is nullptr");
-    LOGGER_DEBUG("Initialising list with requested capacity %lu", capacity);
+    LOGGER_DEBUG("Initialising list with requested capacity %lu (storage kind %d)", capacity, (int)storage_kind);
 
     error_code error = 0;
     if (capacity < MIN_LIST_SIZE) {
         LOGGER_INFO("Requested capacity too small, adjusting to %lu", MIN_LIST_SIZE);
         capacity = MIN_LIST_SIZE;
     }
-
-    size_t alloc_count = capacity ON_DEBUG(+ 1); 
-    LOGGER_DEBUG("Allocating %lu nodes", alloc_count);
-    node_t* arr = (node_t*)(calloc(alloc_count, sizeof(node_t)));
-    if (arr == nullptr) {
-        LOGGER_ERROR("calloc failed during list initialisation");
-        return ERROR_MEM_ALLOC;
+    if (capacity > LIST_MAX_CAPACITY) {
+        LOGGER_ERROR("Requested capacity %lu exceeds index range (max %lu)", capacity, LIST_MAX_CAPACITY);
+        return ERROR_BIG_SIZE;
     }
 
-    for (size_t i = 0; i + 1 < capacity; ++i) {
-        arr[i].next = i + 1;
-        arr[i].prev = -1;
-        arr[i].val  = POISON;
+    list_t list = {};
+    list.storage_kind = storage_kind;
+    if (allocator != nullptr && allocator->alloc != nullptr) {
+        HARD_ASSERT(allocator->realloc != nullptr && allocator->free != nullptr, "allocator callbacks missing");
+        list.allocator = *allocator;
+    }
+    capacity = list_storage_fit_capacity(&list, capacity);
+    error = list_storage_alloc(&list, capacity);
+    if (error != ERROR_NO) {
+        LOGGER_ERROR("calloc failed during list initialisation");
+        return error;
     }
-    arr[capacity - 1].next = -1;
-    arr[capacity - 1].prev = -1;
-    arr[capacity - 1].val  = POISON;
+    list.capacity  = capacity;
 
-    arr[0].next = 0;
-    arr[0].prev = 0;
-    arr[0].val = CANARY_NUM;
+    node_next(&list, 0) = 0;
+    node_prev(&list, 0) = 0;
+    node_val (&list, 0) = CANARY_NUM;
 
     ON_DEBUG(
-        arr[capacity].val = CANARY_NUM;
+        node_val(&list, capacity) = CANARY_NUM;
     ) 
 
-    list_t list = {};
-    list.arr       = arr;
-    list.capacity  = capacity;
     list.size      = 1;          
     list.head      = 0;
     list.tail      = 0;
-    list.free_head = 1;
+    list.free_head = -1;
+    list.untouched = 1;
+    list.linear_prefix = 0;
     ON_DEBUG(
         list.ver_info = ver_info;
     )
 
     *list_return = list;
+    list_storage_relocate(list_return, &list);
     ON_DEBUG(
-        error |= list_verify(&list, VER_INIT, DUMP_IMG, "After list_init");
+        error |= list_verify(list_return, VER_INIT, DUMP_IMG, "After list_init");
+    )
+    return error;
+}
+
+error_code list_node_pool_init(list_node_pool_t* pool, size_t capacity, list_storage_kind_t storage_kind,
+                               const list_allocator_t* allocator ON_DEBUG(, ver_info_t ver_info)) {
+    HARD_ASSERT(pool != nullptr, "pool is nullptr");
+    LOGGER_DEBUG("Initialising node pool with capacity %lu", capacity);
+    return list_init_with_allocator(&pool->store, capacity, storage_kind, allocator ON_DEBUG(, ver_info));
+}
+
+error_code list_node_pool_dest(list_node_pool_t* pool) {
+    HARD_ASSERT(pool != nullptr, "pool is nullptr");
+    LOGGER_DEBUG("Destroying node pool");
+    return list_dest(&pool->store);
+}
+
+// The list's sentinel is one pool slot; everything else is taken on demand.
+error_code list_init_in_pool(list_t* list_return, list_node_pool_t* pool ON_DEBUG(, ver_info_t ver_info)) {
+    HARD_ASSERT(list_return != nullptr,        "list_return is nullptr");
+    HARD_ASSERT(pool != nullptr,               "pool is nullptr");
+    HARD_ASSERT(list_storage_ok(&pool->store), "pool storage is nullptr");
+    LOGGER_DEBUG("Initialising list in node pool");
+
+    list_t* store = &pool->store;
+    ssize_t sentinel = take_free_slot(store);
+    if (sentinel == -1) {
+        error_code grow_err = normalize_capacity(store);
+        if (grow_err != ERROR_NO) {
+            return grow_err;
+        }
+        sentinel = take_free_slot(store);
+        if (sentinel == -1) {
+            return ERROR_MEM_ALLOC;
+        }
+    }
+    store->size++;
+
+    list_t list = {};
+    list.storage_kind  = store->storage_kind;
+    list.pool          = pool;
+    list.sentinel      = sentinel;
+    node_next(&list, 0) = 0;
+    node_prev(&list, 0) = 0;
+    node_val (&list, 0) = CANARY_NUM;
+
+    list.size          = 1;
+    list.head          = 0;
+    list.tail          = 0;
+    list.free_head     = -1;
+    list.linear_prefix = 0;
+    ON_DEBUG(
+        list.ver_info  = ver_info;
+        list.dump_file = store->dump_file;
+    )
+
+    *list_return = list;
+    error_code error = normalize_capacity(store);
+    ON_DEBUG(
+        error |= list_verify(list_return, VER_INIT, DUMP_IMG, "After list_init_in_pool");
     )
     return error;
 }
 
 error_code list_dest(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "list->arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "list->arr is nullptr");
     LOGGER_DEBUG("Destroying list");
     error_code error = ERROR_NO;
 
-    free(list->arr);
-    list->arr = nullptr;
+    if (list->pool != nullptr) {
+        // Nodes and sentinel go back to the pool's free chain
+        list_t* store = &list->pool->store;
+        if (list->head != 0) {
+            free_range(list, list->head, list->tail);
+        }
+        push_free_slot(store, list->sentinel);
+        store->size -= list->size;
+        *list = {};
+        return error;
+    }
+
+    list_order_index_disable(list);
+    list_handles_disable(list);
+    list_value_index_disable(list);
+    list_storage_free(list);
     list->capacity = 0;
     list->size = 0;
     list->head = list->tail = list->free_head = 0;
+    list->untouched = 0;
+    list->linear_prefix = 0;
+    list->seq_links = 0;
+    list->mutations = 0;
+    list->finger_physical = 0;
     return error;
 }
 
 ssize_t list_insert_after(list_t* list, ssize_t insert_index, double val) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Inserting value %lf after index %d", val, insert_index);
 
     ON_DEBUG(
@@ -175,37 +771,37 @@ ssize_t list_insert_after(list_t* list, ssize_t insert_index, double val) {
             return -1;
         }
     )
-    if (insert_index < 0 || (size_t)(insert_index) >= list->capacity) {
+    if (insert_index < 0 || (size_t)(insert_index) >= list_store(list)->untouched) {
         LOGGER_ERROR("insert_index %d out of bounds", insert_index);
         return -1;
     }
 
-    ssize_t free_index = list->free_head;
+    ssize_t free_index = take_free_slot(list);
     if (free_index == -1) {
         LOGGER_ERROR("No free cells available, grow required");
         error_code grow_err = normalize_capacity(list);
         if (grow_err != ERROR_NO) {
             return -1;
         }
-        free_index = list->free_head;
+        free_index = take_free_slot(list);
         if (free_index == -1) {
             return -1;
         }
     }
-    list->free_head = list->arr[free_index].next;
 
-    ssize_t next_index  = list->arr[insert_index].next;
-    list->arr[free_index].val  = val;
-    list->arr[free_index].next = next_index;
-    list->arr[free_index].prev = insert_index;
+    ssize_t next_index  = node_next(list, insert_index);
+    node_val(list, free_index)  = val;
+    node_next(list, free_index) = as_index(next_index);
+    node_prev(list, free_index) = as_index(insert_index);
 
-    list->arr[insert_index].next = free_index;
-    list->arr[next_index].prev   = free_index;
+    node_next(list, insert_index) = as_index(free_index);
+    node_prev(list, next_index)   = as_index(free_index);
 
-    list->head = list->arr[0].next;
-    list->tail = list->arr[0].prev;
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+    on_node_linked(list, insert_index, free_index);
 
-    list->size++;
+    adjust_size(list, 1);
     ON_DEBUG(
         error |= list_verify(list, VER_INIT, DUMP_IMG, "After insert of %lf at index %d", val, insert_index);
         if (error != ERROR_NO) {
@@ -219,54 +815,380 @@ ssize_t list_insert_after(list_t* list, ssize_t insert_index, double val) {
         return -1;
     }
 
+    if (maybe_relayout(list, 1, &free_index) != ERROR_NO) {
+        LOGGER_ERROR("Failed to relayout after insert");
+        return -1;
+    }
+    compact_nodes(list, list->compact_budget, &free_index);
     return free_index;
 }
 
+// Links `count` values after insert_index in one pass. Slots come from the
+// untouched tail when it has room, so the run is physically contiguous (and
+// extends the linear prefix when appended to it); otherwise from the free chain.
+ssize_t list_insert_range_after(list_t* list, ssize_t insert_index, const double* vals, size_t count) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    HARD_ASSERT(vals != nullptr || count == 0, "vals is nullptr");
+    LOGGER_DEBUG("Inserting %lu values after index %d", count, insert_index);
+
+    ON_DEBUG(
+        error_code error = list_verify(list, VER_INIT, DUMP_IMG, "Before insert of %lu values at index %d", count, insert_index);
+        if (error != ERROR_NO) {
+            return -1;
+        }
+    )
+    if (insert_index < 0 || (size_t)(insert_index) >= list_store(list)->untouched) {
+        LOGGER_ERROR("insert_index %d out of bounds", insert_index);
+        return -1;
+    }
+    if (count == 0) {
+        return insert_index;
+    }
+    if (reserve_for(list, count) != ERROR_NO) {
+        return -1;
+    }
+
+    const list_t* store   = list_store(list);
+    const bool contiguous = store->untouched + count <= store->capacity;
+    ssize_t next_index = node_next(list, insert_index);
+    ssize_t prev_index = insert_index;
+    ssize_t first      = -1;
+    for (size_t i = 0; i < count; ++i) {
+        prev_index = chain_slot(list, prev_index, contiguous, vals[i]);
+        if (first == -1) first = prev_index;
+    }
+    node_next(list, prev_index) = as_index(next_index);
+    node_prev(list, next_index) = as_index(prev_index);
+
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+    adjust_size(list, (ssize_t)count);
+    on_run_linked(list, insert_index, first, count);
+
+    ON_DEBUG(
+        error |= list_verify(list, VER_INIT, DUMP_IMG, "After insert of %lu values at index %d", count, insert_index);
+        if (error != ERROR_NO) {
+            return -1;
+        }
+    )
+    if (maybe_relayout(list, count, &prev_index) != ERROR_NO) {
+        LOGGER_ERROR("Failed to relayout after insert");
+        return -1;
+    }
+    compact_nodes(list, list->compact_budget, &prev_index);
+    return prev_index;
+}
+
+ssize_t list_push_back_bulk(list_t* list, const double* vals, size_t count) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    return list_insert_range_after(list, list->tail, vals, count);
+}
+
+error_code list_from_array(list_t* list_return, const double* vals, size_t count
+                           ON_DEBUG(, ver_info_t ver_info)) {
+    HARD_ASSERT(list_return != nullptr, "list_return is nullptr");
+    LOGGER_DEBUG("Building list from %lu values", count);
+
+    if (count > LIST_MAX_CAPACITY - 2) {
+        LOGGER_ERROR("Too many values for one list: %lu", count);
+        return ERROR_BIG_SIZE;
+    }
+    error_code error = list_init(list_return, count + 2 ON_DEBUG(, ver_info));
+    if (error != ERROR_NO) {
+        return error;
+    }
+    if (list_push_back_bulk(list_return, vals, count) == -1) {
+        list_dest(list_return);
+        return ERROR_INSERT_FAIL;
+    }
+    return ERROR_NO;
+}
+
+static bool range_args_ok(const list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    const size_t untouched = list_store(list)->untouched;
+    return first_idx > 0 && (size_t)first_idx < untouched && !list_node_is_free(list, first_idx) &&
+           last_idx  > 0 && (size_t)last_idx  < untouched && !list_node_is_free(list, last_idx);
+}
+
+// Moves first..last (a run in logical order) of src after dest_after in dest.
+// Within one list the run is walked once to check it, then relinked in O(1);
+// between two lists its values move into one run of freshly reserved dest
+// slots and the src slots go to src's free chain. Returns the dest slot now
+// holding first, -1 on failure.
+ssize_t list_splice(list_t* dest, ssize_t dest_after, list_t* src, ssize_t first_idx, ssize_t last_idx) {
+    HARD_ASSERT(dest != nullptr && src != nullptr,             "list is nullptr");
+    HARD_ASSERT(list_storage_ok(dest) && list_storage_ok(src), "arr is nullptr");
+    LOGGER_DEBUG("Splicing %d..%d after index %d", first_idx, last_idx, dest_after);
+
+    ON_DEBUG(
+        error_code error = list_verify(dest, VER_INIT, DUMP_IMG, "Before splice into index %d", dest_after);
+        if (src != dest) {
+            error |= list_verify(src, VER_INIT, DUMP_IMG, "Before splice of %d..%d", first_idx, last_idx);
+        }
+        if (error != ERROR_NO) {
+            return -1;
+        }
+    )
+    if (!splice_args_ok(dest, dest_after, src, first_idx, last_idx) ||
+        !pool_owns(dest, dest_after) || !pool_owns(src, first_idx)) {
+        LOGGER_ERROR("list_splice: bad indices %d after %d", first_idx, dest_after);
+        return -1;
+    }
+
+    if (src == dest) {
+        if (!run_excludes(dest, first_idx, last_idx, dest_after)) {
+            LOGGER_ERROR("list_splice: %d is inside %d..%d or the run is broken", dest_after, first_idx, last_idx);
+            return -1;
+        }
+        move_run(dest, dest_after, first_idx, last_idx);
+        ON_DEBUG(
+            error |= list_verify(dest, VER_INIT, DUMP_IMG, "After splice of %d..%d", first_idx, last_idx);
+            if (error != ERROR_NO) return -1;
+        )
+        return first_idx;
+    }
+
+    ssize_t length = range_length(src, first_idx, last_idx);
+    if (length == -1) {
+        LOGGER_ERROR("list_splice: %d does not follow %d", last_idx, first_idx);
+        return -1;
+    }
+    size_t count = (size_t)length;
+
+    // Two lists of one node pool share the slots: relink like within one list
+    if (src->pool != nullptr && src->pool == dest->pool) {
+        on_range_unlinked(src, first_idx, last_idx);
+        unlink_range(src, first_idx, last_idx);
+        link_range(dest, dest_after, first_idx, last_idx);
+        src->head   = node_next(src, 0);
+        src->tail   = node_prev(src, 0);
+        src->size  -= count;
+        dest->head  = node_next(dest, 0);
+        dest->tail  = node_prev(dest, 0);
+        dest->size += count;
+        on_run_linked(dest, dest_after, first_idx, count);
+
+        ON_DEBUG(
+            error |= list_verify(dest, VER_INIT, DUMP_IMG, "After splice into index %d", dest_after);
+            error |= list_verify(src,  VER_INIT, DUMP_IMG, "After splice of %d..%d", first_idx, last_idx);
+            if (error != ERROR_NO) return -1;
+        )
+        return first_idx;
+    }
+
+    if (reserve_for(dest, count) != ERROR_NO) {
+        return -1;
+    }
+
+    const list_t* store   = list_store(dest);
+    const bool contiguous = store->untouched + count <= store->capacity;
+    ssize_t next_index = node_next(dest, dest_after);
+    ssize_t prev_index = dest_after;
+    ssize_t new_first  = -1;
+    for (ssize_t cur = first_idx; ; cur = node_next(src, cur)) {
+        prev_index = chain_slot(dest, prev_index, contiguous, node_val(src, cur));
+        if (new_first == -1) new_first = prev_index;
+        if (cur == last_idx) break;
+    }
+    node_next(dest, prev_index) = as_index(next_index);
+    node_prev(dest, next_index) = as_index(prev_index);
+
+    dest->head  = node_next(dest, 0);
+    dest->tail  = node_prev(dest, 0);
+    adjust_size(dest, (ssize_t)count);
+    on_run_linked(dest, dest_after, new_first, count);
+
+    on_range_unlinked(src, first_idx, last_idx);
+    unlink_range(src, first_idx, last_idx);
+    free_range(src, first_idx, last_idx);
+    src->head  = node_next(src, 0);
+    src->tail  = node_prev(src, 0);
+    adjust_size(src, -(ssize_t)count);
+
+    ON_DEBUG(
+        error |= list_verify(dest, VER_INIT, DUMP_IMG, "After splice into index %d", dest_after);
+        error |= list_verify(src,  VER_INIT, DUMP_IMG, "After splice of %d..%d", first_idx, last_idx);
+        if (error != ERROR_NO) return -1;
+    )
+    return new_first;
+}
+
+ssize_t list_splice_unchecked(list_t* list, ssize_t dest_after, ssize_t first_idx, ssize_t last_idx) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Splicing %d..%d after index %d unchecked", first_idx, last_idx, dest_after);
+
+    if (!splice_args_ok(list, dest_after, list, first_idx, last_idx)) {
+        LOGGER_ERROR("list_splice_unchecked: bad indices %d after %d", first_idx, dest_after);
+        return -1;
+    }
+    ON_DEBUG(
+        error_code error = list_verify(list, VER_INIT, DUMP_IMG, "Before splice into index %d", dest_after);
+        if (error != ERROR_NO || !pool_owns(list, dest_after) || !pool_owns(list, first_idx) ||
+            !run_excludes(list, first_idx, last_idx, dest_after)) {
+            LOGGER_ERROR("list_splice_unchecked: %d is inside %d..%d or the run is broken",
+                         dest_after, first_idx, last_idx);
+            return -1;
+        }
+    )
+    move_run(list, dest_after, first_idx, last_idx);
+    ON_DEBUG(
+        error |= list_verify(list, VER_INIT, DUMP_IMG, "After splice of %d..%d", first_idx, last_idx);
+        if (error != ERROR_NO) return -1;
+    )
+    return first_idx;
+}
+
+// Moves split_index..tail into a new list; the tail list starts out linear.
+error_code list_split_at(list_t* list, ssize_t split_index, list_t* tail_return
+                         ON_DEBUG(, ver_info_t ver_info)) {
+    HARD_ASSERT(list != nullptr,        "list is nullptr");
+    HARD_ASSERT(tail_return != nullptr, "tail_return is nullptr");
+    HARD_ASSERT(list_storage_ok(list),  "arr is nullptr");
+    LOGGER_DEBUG("Splitting list at index %d", split_index);
+
+    if (!range_args_ok(list, split_index, split_index)) {
+        LOGGER_ERROR("list_split_at: bad index %d", split_index);
+        return ERROR_INCORRECT_INDEX;
+    }
+    ssize_t length = range_length(list, split_index, list->tail);
+    if (length == -1) {
+        return ERROR_INVALID_STRUCTURE;
+    }
+
+    error_code error = list->pool != nullptr
+                     ? list_init_in_pool(tail_return, list->pool ON_DEBUG(, ver_info))
+                     : list_init_with_allocator(tail_return, (size_t)length + 2, list->storage_kind,
+                                                &list->allocator ON_DEBUG(, ver_info));
+    if (error != ERROR_NO) {
+        return error;
+    }
+    tail_return->shrink_policy = list->shrink_policy;
+    tail_return->compact_budget = list->compact_budget;
+    tail_return->relayout_policy = list->relayout_policy;
+    if (list_splice(tail_return, 0, list, split_index, list->tail) == -1) {
+        list_dest(tail_return);
+        return ERROR_INSERT_FAIL;
+    }
+    return ERROR_NO;
+}
+
+// Appends all of src to dest; src is left empty but initialised.
+error_code list_concat(list_t* dest, list_t* src) {
+    HARD_ASSERT(dest != nullptr && src != nullptr, "list is nullptr");
+    HARD_ASSERT(dest != src,                       "cannot concat a list with itself");
+
+    if (src->size <= 1) {
+        return ERROR_NO;
+    }
+    if (list_splice(dest, dest->tail, src, src->head, src->tail) == -1) {
+        return ERROR_INSERT_FAIL;
+    }
+    return ERROR_NO;
+}
+
+// Single-node splice without its checks and bookkeeping: the node keeps its
+// slot, nothing is allocated or freed, and the list is verified once.
+error_code list_move_after(list_t* list, ssize_t node_idx, ssize_t dest_idx) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    const size_t untouched = list_store(list)->untouched;
+    if (node_idx <= 0 || (size_t)node_idx >= untouched || node_idx == list->sentinel ||
+        list_node_is_free(list, node_idx) ||
+        dest_idx < 0  || (size_t)dest_idx >= untouched || list_node_is_free(list, dest_idx) ||
+        !pool_owns(list, node_idx) || !pool_owns(list, dest_idx)) {
+        LOGGER_ERROR("list_move_after: bad indices %d after %d", node_idx, dest_idx);
+        return ERROR_INCORRECT_INDEX;
+    }
+    ssize_t old_next      = node_next(list, node_idx);
+    ssize_t old_dest_next = node_next(list, dest_idx);
+    if (node_idx == dest_idx || node_prev(list, node_idx) == dest_idx) {
+        return ERROR_NO;
+    }
+
+    on_range_moved(list, node_idx, node_idx, dest_idx, old_next, old_dest_next);
+    unlink_range(list, node_idx, node_idx);
+    link_range(list, dest_idx, node_idx, node_idx);
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+
+    error_code error = ERROR_NO;
+    ON_DEBUG(
+        error |= list_verify(list, VER_INIT, DUMP_IMG, "After moving %d after %d", node_idx, dest_idx);
+    )
+    return error;
+}
+
+error_code list_move_to_front(list_t* list, ssize_t node_idx) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    return list_move_after(list, node_idx, 0);
+}
+
+error_code list_move_to_back(list_t* list, ssize_t node_idx) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    return list_move_after(list, node_idx, list->tail);
+}
+
 ssize_t list_insert_auto(list_t* list, ssize_t insert_index, double val) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
 
     if (insert_index < 0 || (size_t)insert_index > list->size) {
         LOGGER_ERROR("list_insert_auto: insert_index %d out of range", insert_index);
         return -1;
     }
-    ssize_t physical = list->head;
-    for (ssize_t i = 0; i < insert_index; ++i) {
-        physical = list->arr[physical].next;
+    ssize_t physical = resolve_logical(list, insert_index);
+    set_finger(list, insert_index, physical);
+    ssize_t inserted = list_insert_after(list, physical, val);
+    if (inserted != -1) {
+        set_finger(list, physical == 0 ? 0 : insert_index + 1, inserted);
     }
-    return list_insert_after(list, physical, val);
+    return inserted;
+}
+
+ssize_t list_resolve_auto(const list_t* list, ssize_t logical_index) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    if (logical_index < 0 || (size_t)logical_index >= list->size - 1) {
+        LOGGER_ERROR("list_resolve_auto: logical_index %d out of range", logical_index);
+        return -1;
+    }
+    return resolve_logical(list, logical_index);
 }
 
 ssize_t list_insert_before(list_t* list, ssize_t insert_index, double val) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Inserting before physical index %d", insert_index);
 
-    if (insert_index < 0 || (size_t)(insert_index) >= list->capacity) {
+    if (insert_index < 0 || (size_t)(insert_index) >= list_store(list)->untouched) {
         LOGGER_ERROR("list_insert_before: insert_index %d invalid", insert_index);
         return -1;
     }
-    ssize_t prev_index = list->arr[insert_index].prev;
+    ssize_t prev_index = node_prev(list, insert_index);
     return list_insert_after(list, prev_index, val);
 }
 
 ssize_t list_push_back(list_t* list, double val) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Pushing back value %lf", val);
     return list_insert_before(list, 0, val);
 }
 
 ssize_t list_push_front(list_t* list, double val) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Pushing front value %lf", val);
     return list_insert_after(list, 0, val);
 }
 
 error_code list_remove(list_t* list, ssize_t remove_index) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Removing node at physical index %d", remove_index);
 
     error_code error = 0;
@@ -276,126 +1198,91 @@ error_code list_remove(list_t* list, ssize_t remove_index) {
             return error;
         }
     )
-    if (remove_index <= 0 || (size_t)(remove_index) >= list->capacity) {
+    if (remove_index <= 0 || remove_index == list->sentinel || (size_t)(remove_index) >= list_store(list)->capacity) {
         LOGGER_ERROR("list_remove: index %d out of range", remove_index);
         return ERROR_INCORRECT_INDEX;
     }
-    if (list_node_is_free(&list->arr[remove_index])) {  
+    if (list_node_is_free(list, remove_index)) {  
         LOGGER_ERROR("list_remove: node %d is already free", remove_index);
         return ERROR_INCORRECT_INDEX;
     }
 
-    ssize_t prev_index = list->arr[remove_index].prev;
-    ssize_t next_index = list->arr[remove_index].next;
+    ssize_t prev_index = node_prev(list, remove_index);
+    ssize_t next_index = node_next(list, remove_index);
 
-    list->arr[prev_index].next = next_index;
-    list->arr[next_index].prev = prev_index;
+    node_next(list, prev_index) = as_index(next_index);
+    node_prev(list, next_index) = as_index(prev_index);
 
-    list->head = list->arr[0].next;
-    list->tail = list->arr[0].prev;
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
 
-    list->arr[remove_index].next = list->free_head;
-    list->arr[remove_index].prev = -1;
-    list->arr[remove_index].val  = POISON;
-    list->free_head = remove_index;
+    on_node_unlinked(list, remove_index);
+    push_free_slot(list, remove_index);
 
-    list->size--;
+    adjust_size(list, -1);
     ON_DEBUG(
         error |= list_verify(list, VER_INIT, DUMP_IMG, "After removal at index %d", remove_index);
         if (error != ERROR_NO) {
             return error;
         }
     )
-    return ERROR_NO;
+    error = maybe_shrink(list);
+    error |= maybe_relayout(list, 1, nullptr);
+    compact_nodes(list, list->compact_budget, nullptr);
+    return error;
 }
 
 error_code list_remove_auto(list_t* list, ssize_t remove_index) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Removing logical index %d", remove_index);
     if (remove_index < 0 || (size_t)remove_index >= list->size - 1) {
         LOGGER_ERROR("list_remove_auto: remove_index %d out of range", remove_index);
         return ERROR_INCORRECT_INDEX;
     }
-    ssize_t physical_index = list->head;
-    for (ssize_t i = 0; i < remove_index; ++i) {
-        physical_index = list->arr[physical_index].next;
-    }
+    ssize_t physical_index = resolve_logical(list, remove_index);
+    set_finger(list, remove_index, physical_index);
     return list_remove(list, physical_index);
 }
 
 error_code list_pop_back(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Popping back");
-    return list_remove(list, list->arr[0].prev);
+    return list_remove(list, node_prev(list, 0));
 }
 
 error_code list_pop_front(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Popping front");
-    return list_remove(list, list->arr[0].next);
+    return list_remove(list, node_next(list, 0));
 }
 
 error_code list_swap(list_t* list, ssize_t first_idx, ssize_t second_idx) {
     HARD_ASSERT(list != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
     LOGGER_DEBUG("Swapping indices %d and %d", first_idx, second_idx);
 
     error_code error = 0;
     if (first_idx <= 0 || second_idx <= 0 ||
-        (size_t)(first_idx) >= list->capacity ||
-        (size_t)(second_idx) >= list->capacity) {
+        (size_t)(first_idx) >= list_store(list)->untouched ||
+        (size_t)(second_idx) >= list_store(list)->untouched) {
         LOGGER_ERROR("One or both indices out of range");
         return ERROR_INCORRECT_INDEX;
     }
-    if (first_idx == 0 || second_idx == 0) {
+    if (first_idx == list->sentinel || second_idx == list->sentinel) {
         LOGGER_ERROR("index 0 is sentinel and cannot be swapped");
         return ERROR_INCORRECT_INDEX;
     }
 
-    node_t* first_elem  = &list->arr[first_idx];
-    node_t* second_elem = &list->arr[second_idx];
-
-    if (!list_node_is_free(first_elem) && !list_node_is_free(second_elem)) {
-        list->arr[first_elem->next].prev = second_idx;
-        list->arr[first_elem->prev].next = second_idx;
-        node_t temp = *first_elem;
-        *first_elem = *second_elem;
-        *second_elem = temp;
-
-    } else if (!list_node_is_free(second_elem)) {
-        list->arr[second_elem->next].prev = first_idx;
-        list->arr[second_elem->prev].next = first_idx;
-        *first_elem = *second_elem;
-        second_elem->val  = POISON;
-        second_elem->prev = -1;
-        second_elem->next = -1;
-
-    } else if(!list_node_is_free(first_elem)) {
-        list->arr[first_elem->next].prev = second_idx;
-        list->arr[first_elem->prev].next = second_idx;
-        *second_elem = *first_elem;
-        first_elem->val  = POISON;
-        first_elem->prev = -1;
-        first_elem->next = -1;
-
-    } else {
-        first_elem->val  = POISON;
-        first_elem->prev = -1;
-        first_elem->next = -1;
-
-        second_elem->val  = POISON;
-        second_elem->prev = -1;
-        second_elem->next = -1;
-    }
+    swap_slots(list, first_idx, second_idx, true);
     return error;
 }
 
 static error_code list_reorganize_free(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
 
     LOGGER_DEBUG("Reorganizing free list");
 
@@ -407,25 +1294,14 @@ static error_code list_reorganize_free(list_t* list) {
 
     ssize_t first_free = list->size;  
 
-    if((size_t)first_free == list->capacity) {
-        list->free_head = -1;
-        return ERROR_NO;
-    }
-
     if ((size_t)first_free > list->capacity) {
         list->free_head = -1;
         return ERROR_BIG_SIZE;
     }
 
-    list->free_head = first_free;
-    for (size_t i = (size_t)first_free; i + 1 < list->capacity; ++i) {
-        list->arr[i].prev = -1;
-        list->arr[i].val  = POISON;
-        list->arr[i].next = i + 1;
-    }
-    list->arr[list->capacity - 1].prev = -1;
-    list->arr[list->capacity - 1].val  = POISON;
-    list->arr[list->capacity - 1].next = -1;
+    // Everything past the packed prefix becomes untouched again
+    list->free_head = -1;
+    list->untouched = (size_t)first_free;
 
     ON_DEBUG(
         error |= list_verify(list, VER_INIT, DUMP_IMG, "After reorganize_free");
@@ -434,56 +1310,233 @@ static error_code list_reorganize_free(list_t* list) {
 }
 
 error_code list_linearize(list_t* list) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
 
     LOGGER_DEBUG("Linearizing list");
 
-    error_code error = 0;
-
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot be relaid out");
+        return ERROR_INCORRECT_ARGS;
+    }
     ON_DEBUG(
-        error |= list_verify(list, VER_INIT, DUMP_IMG, "Before linearize");
+        error_code error = list_verify(list, VER_INIT, DUMP_IMG, "Before linearize");
         if (error != ERROR_NO) return error;
     )
 
     const ssize_t n = list->size - 1;
     if (n <= 0) {
-        list->arr[0].next = 0;
-        list->arr[0].prev = 0;
+        node_next(list, 0) = 0;
+        node_prev(list, 0) = 0;
         list->head = 0;
         list->tail = 0;
+        on_relayout(list);
         return list_reorganize_free(list);
     }
 
-    ssize_t cur = list->arr[0].next; 
+    // cheaper to rebuild the order index once than to follow every swap
+    order_index_invalidate(list);
+
+    ssize_t cur = node_next(list, 0); 
     for (ssize_t i = 1; i <= n; ++i) {
         if (cur != i) {
-            error |= list_swap(list, i, cur);
-            if (error != ERROR_NO) return error;
+            swap_slots(list, i, cur, false);
         }
-        cur = list->arr[i].next;
+        cur = node_next(list, i);
     }
 
-    list->arr[1].prev = 0;
-    list->arr[1].next = 2;
+    node_prev(list, 1) = 0;
+    node_next(list, 1) = 2;
     for (ssize_t i = 2; i < n; i++) {
-        list->arr[i].prev = i - 1;
-        list->arr[i].next = i + 1;
+        node_prev(list, i) = as_index(i - 1);
+        node_next(list, i) = as_index(i + 1);
     }
-    list->arr[n].prev = n - 1;
-    list->arr[n].next = 0;
+    node_prev(list, n) = as_index(n - 1);
+    node_next(list, n) = 0;
 
-    list->arr[0].next = 1;
-    list->arr[0].prev = n;
+    node_next(list, 0) = 1;
+    node_prev(list, 0) = as_index(n);
     list->head = 1;
     list->tail = n;
+    on_relayout(list);
+
+    return list_reorganize_free(list);
+}
+
+// Out-of-place relayout. Walking the chain node by node is bound by one
+// cache miss per node, so the chain is cut into runs at every live slot
+// divisible by RUN_STRIDE (and at head), and CHASE_STREAMS runs are walked
+// in lockstep so their misses overlap. The first pass measures the runs, the
+// second copies each run straight to its final place in fresh storage. One
+// pass cannot place a run before the runs ahead of it are measured; two
+// lockstep passes still beat a single serial walk, about 110 vs 200 ns/node
+// at 1M fragmented nodes and 150 vs 400 at 10M (AoS, `-b linearize`).
+
+static const ssize_t RUN_STRIDE    = 64;
+static const int     CHASE_STREAMS = 16;
+
+struct chase_run_t {
+    ssize_t length;
+    ssize_t next_run;  // id of the following run, -1 for the last one
+    ssize_t start;     // destination slot of the run's first node
+};
+
+// Run ids: slot / RUN_STRIDE for stride slots, 0 for a head off the stride
+static inline ssize_t run_id(ssize_t run_start) {
+    return run_start % RUN_STRIDE == 0 ? run_start / RUN_STRIDE : 0;
+}
+
+static ssize_t next_run_start(const list_t* list, ssize_t* scan) {
+    if (*scan == 0) {
+        *scan = RUN_STRIDE;
+        if (list->head % RUN_STRIDE != 0) {
+            return list->head;
+        }
+    }
+    while ((size_t)*scan < list->untouched) {
+        ssize_t slot = *scan;
+        *scan += RUN_STRIDE;
+        if (!list_node_is_free(list, slot)) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// fresh == nullptr: measuring pass, fills length/next_run.
+// Otherwise copies every node to runs[].start + offset and records the remap.
+static void chase_runs(const list_t* list, chase_run_t* runs, const list_t* fresh, list_index_t* remap) {
+    struct stream_t {
+        ssize_t run;
+        ssize_t cur;
+        ssize_t offset;
+    } streams[CHASE_STREAMS] = {};
+
+    ssize_t scan   = 0;
+    int     active = 0;
+    for (; active < CHASE_STREAMS; ++active) {
+        ssize_t run_start = next_run_start(list, &scan);
+        if (run_start == -1) break;
+        streams[active] = {run_id(run_start), run_start, 0};
+    }
+
+    while (active > 0) {
+        for (int i = 0; i < active; ++i) {
+            stream_t* stream = &streams[i];
+            ssize_t   cur    = stream->cur;
+            ssize_t   next   = node_next(list, cur);
+            if (fresh != nullptr) {
+                ssize_t pos = runs[stream->run].start + stream->offset;
+                node_val (fresh, pos) = node_val(list, cur);
+                node_prev(fresh, pos) = as_index(pos - 1);
+                node_next(fresh, pos) = as_index(pos + 1);
+                if (remap != nullptr) {
+                    remap[cur] = as_index(pos);
+                }
+            }
+            stream->offset++;
+
+            if (next != 0 && next % RUN_STRIDE != 0) {
+                stream->cur = next;
+                continue;
+            }
+            if (fresh == nullptr) {
+                runs[stream->run].length   = stream->offset;
+                runs[stream->run].next_run = next == 0 ? -1 : run_id(next);
+            }
+            ssize_t run_start = next_run_start(list, &scan);
+            if (run_start != -1) {
+                *stream = {run_id(run_start), run_start, 0};
+            } else {
+                *stream = streams[--active];
+                --i;
+            }
+        }
+    }
+}
+
+// Streams the chain into fresh storage in logical order instead of swapping
+// nodes into place. Costs a second node array for the duration of the call.
+error_code list_linearize_copy(list_t* list, list_index_t* remap) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    LOGGER_DEBUG("Linearizing list out of place");
+
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot be relaid out");
+        return ERROR_INCORRECT_ARGS;
+    }
+    ON_DEBUG(
+        error_code error = list_verify(list, VER_INIT, DUMP_IMG, "Before linearize_copy");
+        if (error != ERROR_NO) return error;
+    )
+
+    const ssize_t n = (ssize_t)list->size - 1;
+    chase_run_t* runs = (chase_run_t*)calloc(list->capacity / RUN_STRIDE + 1, sizeof(chase_run_t));
+    // handles follow the nodes through the remap, so one is needed anyway
+    list_index_t* owned_remap = nullptr;
+    if (remap == nullptr && list->handles != nullptr) {
+        owned_remap = (list_index_t*)malloc(list->capacity * sizeof(list_index_t));
+        remap       = owned_remap;
+    }
+    list_t fresh = {};
+    fresh.storage_kind = list->storage_kind;
+    fresh.allocator    = list->allocator;
+    fresh.capacity     = list->capacity;  // sizes the old block when it is freed after the swap
+    if (runs == nullptr || (list->handles != nullptr && remap == nullptr) ||
+        list_storage_alloc(&fresh, list->capacity) != ERROR_NO) {
+        LOGGER_ERROR("No memory for out-of-place linearize");
+        free(runs);
+        free(owned_remap);
+        return ERROR_MEM_ALLOC;
+    }
+    if (remap != nullptr) {
+        for (size_t i = 0; i < list->capacity; ++i) {
+            remap[i] = -1;
+        }
+        remap[0] = 0;
+    }
+
+    if (n > 0) {
+        chase_runs(list, runs, nullptr, nullptr);
+        ssize_t pos = 1;
+        for (ssize_t run = run_id(list->head); run != -1; run = runs[run].next_run) {
+            runs[run].start = pos;
+            pos += runs[run].length;
+        }
+        HARD_ASSERT(pos == n + 1, "runs do not cover the list");
+        chase_runs(list, runs, &fresh, remap);
+        node_next(&fresh, n) = 0;
+    }
+    free(runs);
+
+    node_val (&fresh, 0) = CANARY_NUM;
+    node_prev(&fresh, 0) = as_index(n);
+    node_next(&fresh, 0) = n > 0 ? 1 : 0;
+    ON_DEBUG(
+        node_val(&fresh, list->capacity) = CANARY_NUM;
+    )
+
+    list_storage_swap(list, &fresh);
+    list_storage_free(&fresh);
+
+    list->head = node_next(list, 0);
+    list->tail = node_prev(list, 0);
+    if (handles_relocate(list, remap) != ERROR_NO) {
+        LOGGER_ERROR("Handle table could not follow the relayout, disabling it");
+        list_handles_disable(list);
+    }
+    free(owned_remap);
+    value_index_rebuild(list);
+    on_relayout(list);
 
     return list_reorganize_free(list);
 }
 
 error_code list_shrink_to_fit(list_t* list, bool keep_growth) {
-    HARD_ASSERT(list      != nullptr, "list is nullptr");
-    HARD_ASSERT(list->arr != nullptr, "arr is nullptr");
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
 
     LOGGER_DEBUG("Shrinking list to fit (keep_growth=%d)", (int)keep_growth);
 
@@ -504,25 +1557,24 @@ error_code list_shrink_to_fit(list_t* list, bool keep_growth) {
 
     if (target < MIN_LIST_SIZE) target = MIN_LIST_SIZE;               
     if (target < list->size)    target = list->size;                    
+    target = list_storage_fit_capacity(list, target);
     if (target == list->capacity) {
         return ERROR_NO;
     }
 
-    size_t alloc_count = target ON_DEBUG(+ 1);
-    node_t* new_block = (node_t*)realloc(list->arr, alloc_count * sizeof(node_t));
-    if (!new_block) {
+    error |= list_storage_resize(list, target);
+    if (error != ERROR_NO) {
         LOGGER_ERROR("realloc failed in list_shrink_to_fit");
-        error |= ERROR_MEM_ALLOC;
         return error;
     }
-    list->arr = new_block;
 
     ON_DEBUG(
-        list->arr[0].val       = CANARY_NUM;
-        list->arr[target].val  = CANARY_NUM;
+        node_val(list, 0)       = CANARY_NUM;
+        node_val(list, target)  = CANARY_NUM;
     )
 
     list->capacity = target;
+    on_capacity_changed(list);
 
     error |= list_reorganize_free(list);
     if (error != ERROR_NO) return error;
@@ -535,3 +1587,185 @@ error_code list_shrink_to_fit(list_t* list, bool keep_growth) {
 
     return ERROR_NO;
 }
+
+error_code list_set_shrink_policy(list_t* list, const list_shrink_policy_t* policy) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (policy == nullptr || policy->reduction_factor <= 0) {
+        list->shrink_policy = {};
+        return ERROR_NO;
+    }
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot shrink");
+        return ERROR_INCORRECT_ARGS;
+    }
+    // headroom below reduction_factor leaves a gap between the shrink and
+    // grow thresholds, so a list hovering around one of them does not thrash
+    if (policy->headroom < 1.0f || policy->reduction_factor <= policy->headroom) {
+        LOGGER_ERROR("Bad shrink policy: reduction_factor %g, headroom %g",
+                     (double)policy->reduction_factor, (double)policy->headroom);
+        return ERROR_INCORRECT_ARGS;
+    }
+    list->shrink_policy = *policy;
+    return maybe_shrink(list);
+}
+
+// Capacity to shrink to, or the current one if the policy does not fire
+static size_t shrink_target(const list_t* list) {
+    const list_shrink_policy_t& policy = list->shrink_policy;
+    if (policy.reduction_factor <= 0 ||
+        (double)list->size * (double)policy.reduction_factor >= (double)list->capacity) {
+        return list->capacity;
+    }
+    size_t target = (size_t)((double)list->size * (double)policy.headroom);
+    if (target < list->size + 2)      target = list->size + 2;
+    if (target < policy.min_capacity) target = policy.min_capacity;
+    if (target < MIN_LIST_SIZE)       target = MIN_LIST_SIZE;
+    target = list_storage_fit_capacity(list, target);
+    return target < list->capacity ? target : list->capacity;
+}
+
+// Moves every live node at or above target into a free slot below it and
+// cuts the free chain and untouched tail at target. Nodes already below
+// target stay put, so the cost is the high region plus the free chain.
+static error_code compact_below(list_t* list, size_t target) {
+    ssize_t low_free = -1;
+    ssize_t low_tail = -1;
+    for (ssize_t cur = list->free_head; cur != -1; cur = node_next(list, cur)) {
+        if ((size_t)cur >= target) continue;
+        if (low_tail == -1) low_free = cur;
+        else                node_next(list, low_tail) = as_index(cur);
+        node_prev(list, cur) = as_index(low_tail);
+        low_tail = cur;
+    }
+    if (low_tail != -1) {
+        node_next(list, low_tail) = -1;
+    }
+    list->free_head = low_free;
+
+    // Slots below target are all touched whenever there is anything above it
+    for (size_t high = target; high < list->untouched; ++high) {
+        if (list_node_is_free(list, (ssize_t)high)) continue;
+
+        ssize_t low = take_free_slot(list);
+        HARD_ASSERT(low != -1 && (size_t)low < target, "no free slot below shrink target");
+        poison_node(list, low);
+        swap_slots(list, (ssize_t)high, low, false);
+    }
+    if (list->untouched > target) {
+        list->untouched = target;
+    }
+    return ERROR_NO;
+}
+
+static error_code maybe_shrink(list_t* list) {
+    size_t target = shrink_target(list);
+    if (target == list->capacity) {
+        return ERROR_NO;
+    }
+    LOGGER_DEBUG("Shrinking list from %lu to %lu slots (size %lu)", list->capacity, target, list->size);
+
+    error_code error = compact_below(list, target);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    return list_recalloc(list, target);
+}
+
+// Each unit of budget settles one node: the node following the linear prefix
+// is swapped into the slot right after it, and the prefix grows over it.
+// *follow is a slot the caller still needs, kept pointing at the same node.
+static void compact_nodes(list_t* list, size_t budget, ssize_t* follow) {
+    for (; budget > 0 && !list_is_linear(list); --budget) {
+        const size_t  prefix = list->linear_prefix;
+        const ssize_t target = (ssize_t)prefix + 1;
+        const ssize_t node   = node_next(list, (ssize_t)prefix);
+        if (node != target) {
+            swap_slots(list, node, target, true);
+            if (follow != nullptr) {
+                *follow = swapped_index(*follow, node, target);
+            }
+        }
+        list->linear_prefix = prefix + 1;
+    }
+}
+
+error_code list_compact_step(list_t* list, size_t budget) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Compaction step (budget %lu, prefix %lu)", budget, list->linear_prefix);
+
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot be relaid out");
+        return ERROR_INCORRECT_ARGS;
+    }
+    error_code error = 0;
+    ON_DEBUG(
+        error |= list_verify(list, VER_INIT, DUMP_IMG, "Before compact_step(%lu)", budget);
+        if (error != ERROR_NO) return error;
+    )
+
+    compact_nodes(list, budget, nullptr);
+
+    ON_DEBUG(
+        error |= list_verify(list, VER_INIT, DUMP_IMG, "After compact_step(%lu)", budget);
+    )
+    return error;
+}
+
+error_code list_set_relayout_policy(list_t* list, const list_relayout_policy_t* policy) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (policy == nullptr || policy->min_locality <= 0) {
+        list->relayout_policy = {};
+        return ERROR_NO;
+    }
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot be relaid out");
+        return ERROR_INCORRECT_ARGS;
+    }
+    if (policy->min_locality > 1.0f || policy->amortize < 0) {
+        LOGGER_ERROR("Bad relayout policy: min_locality %g, amortize %g",
+                     (double)policy->min_locality, (double)policy->amortize);
+        return ERROR_INCORRECT_ARGS;
+    }
+    list->relayout_policy = *policy;
+    list->mutations       = 0;
+    return ERROR_NO;
+}
+
+// Linearizes once the relayout policy fires. follow, if given, is a node
+// index that is moved along with its node.
+static error_code maybe_relayout(list_t* list, size_t mutations, ssize_t* follow) {
+    const list_relayout_policy_t& policy = list->relayout_policy;
+    list->mutations += mutations;
+    if (policy.min_locality <= 0 || list->size - 1 < policy.min_size ||
+        (double)list->mutations < (double)policy.amortize * (double)(list->size - 1) ||
+        list_locality(list) >= (double)policy.min_locality) {
+        return ERROR_NO;
+    }
+    LOGGER_DEBUG("Relayout at locality %g after %lu mutations", list_locality(list), list->mutations);
+
+    ssize_t logical = 0;
+    if (follow != nullptr) {
+        for (ssize_t cur = list->head; cur != *follow; cur = node_next(list, cur)) {
+            ++logical;
+        }
+    }
+    error_code error = list_linearize(list);
+    if (error == ERROR_NO && follow != nullptr) {
+        *follow = logical + 1;
+    }
+    return error;
+}
+
+error_code list_set_compact_budget(list_t* list, size_t budget) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (budget != 0 && list->pool != nullptr) {
+        LOGGER_ERROR("Lists in a node pool share their slots and cannot be relaid out");
+        return ERROR_INCORRECT_ARGS;
+    }
+    list->compact_budget = budget;
+    return ERROR_NO;
+}
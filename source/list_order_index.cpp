@@ -0,0 +1,542 @@
+#include "list_order_index.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const list_index_t NIL = 0;
+// a run longer than size / RUN_REBUILD_RATIO is cheaper to rebuild than to insert
+static const size_t       RUN_REBUILD_RATIO = 32;
+
+//==============================================================================
+
+static uint32_t   next_prio(list_order_index_t* index);
+static void       update_count(list_order_index_t* index, list_index_t node);
+static void       replace_child(list_order_index_t* index, list_index_t parent,
+                                list_index_t old_child, list_index_t new_child);
+static void       rotate_up(list_order_index_t* index, list_index_t node);
+static list_index_t leftmost(const list_order_index_t* index, list_index_t node);
+static void       rebuild(const list_t* list);
+static ssize_t    rank_of(const list_order_index_t* index, list_index_t node);
+static void       split(list_order_index_t* index, list_index_t tree, ssize_t count,
+                        list_index_t* left_return, list_index_t* right_return);
+static list_index_t merge(list_order_index_t* index, list_index_t left, list_index_t right);
+static list_index_t cut_range(list_order_index_t* index, list_index_t first, list_index_t last);
+static bool       resize_array(void** array, size_t count, size_t elem_size);
+
+//==============================================================================
+
+static uint32_t next_prio(list_order_index_t* index) {
+    uint64_t x = index->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    index->seed = x;
+    return (uint32_t)(x >> 32);
+}
+
+static void update_count(list_order_index_t* index, list_index_t node) {
+    index->count[node] = as_index(1 + index->count[index->left[node]] + index->count[index->right[node]]);
+}
+
+static void replace_child(list_order_index_t* index, list_index_t parent,
+                          list_index_t old_child, list_index_t new_child) {
+    if (parent == NIL) {
+        index->root = new_child;
+    } else if (index->left[parent] == old_child) {
+        index->left[parent] = new_child;
+    } else {
+        index->right[parent] = new_child;
+    }
+}
+
+static void rotate_up(list_order_index_t* index, list_index_t node) {
+    list_index_t parent      = index->parent[node];
+    list_index_t grandparent = index->parent[parent];
+
+    if (index->left[parent] == node) {
+        list_index_t moved = index->right[node];
+        index->left[parent] = moved;
+        if (moved != NIL) index->parent[moved] = parent;
+        index->right[node] = parent;
+    } else {
+        list_index_t moved = index->left[node];
+        index->right[parent] = moved;
+        if (moved != NIL) index->parent[moved] = parent;
+        index->left[node] = parent;
+    }
+    index->parent[parent] = node;
+    index->parent[node]   = grandparent;
+    replace_child(index, grandparent, parent, node);
+
+    update_count(index, parent);
+    update_count(index, node);
+}
+
+static list_index_t leftmost(const list_order_index_t* index, list_index_t node) {
+    while (index->left[node] != NIL) {
+        node = index->left[node];
+    }
+    return node;
+}
+
+// O(n) Cartesian-tree build over the current chain. The parent array serves
+// as the build stack and is fixed up in a second pass.
+static void rebuild(const list_t* list) {
+    list_order_index_t* index = list->order_index;
+    LOGGER_DEBUG("Rebuilding order index for %lu nodes", list->size - 1);
+
+    list_index_t top = NIL;
+    for (ssize_t cur = list->head; cur != 0; cur = node_next(list, cur)) {
+        list_index_t node = as_index(cur);
+        index->prio[node] = next_prio(index);
+
+        list_index_t last = NIL;
+        while (top != NIL && index->prio[top] < index->prio[node]) {
+            update_count(index, top);
+            last = top;
+            top  = index->parent[top];
+        }
+        index->left[node]  = last;
+        index->right[node] = NIL;
+        if (top != NIL) {
+            index->right[top] = node;
+        }
+        index->parent[node] = top;
+        top = node;
+    }
+
+    list_index_t root = NIL;
+    while (top != NIL) {
+        update_count(index, top);
+        root = top;
+        top  = index->parent[top];
+    }
+
+    for (ssize_t cur = list->head; cur != 0; cur = node_next(list, cur)) {
+        if (index->left[cur]  != NIL) index->parent[index->left[cur]]  = as_index(cur);
+        if (index->right[cur] != NIL) index->parent[index->right[cur]] = as_index(cur);
+    }
+    if (root != NIL) {
+        index->parent[root] = NIL;
+    }
+    index->root  = root;
+    index->stale = false;
+}
+
+static ssize_t rank_of(const list_order_index_t* index, list_index_t node) {
+    ssize_t rank = index->count[index->left[node]];
+    while (index->parent[node] != NIL) {
+        list_index_t parent = index->parent[node];
+        if (index->right[parent] == node) {
+            rank += index->count[index->left[parent]] + 1;
+        }
+        node = parent;
+    }
+    return rank;
+}
+
+// First `count` nodes of `tree` in order go left, the rest right. Parents of
+// the two returned roots are left for the caller to reset.
+static void split(list_order_index_t* index, list_index_t tree, ssize_t count,
+                  list_index_t* left_return, list_index_t* right_return) {
+    if (tree == NIL) {
+        *left_return = *right_return = NIL;
+        return;
+    }
+    ssize_t left_count = index->count[index->left[tree]];
+    if (count <= left_count) {
+        split(index, index->left[tree], count, left_return, &index->left[tree]);
+        *right_return = tree;
+    } else {
+        split(index, index->right[tree], count - left_count - 1, &index->right[tree], right_return);
+        *left_return = tree;
+    }
+    if (index->left[tree]  != NIL) index->parent[index->left[tree]]  = tree;
+    if (index->right[tree] != NIL) index->parent[index->right[tree]] = tree;
+    update_count(index, tree);
+}
+
+static list_index_t merge(list_order_index_t* index, list_index_t left, list_index_t right) {
+    if (left  == NIL) return right;
+    if (right == NIL) return left;
+
+    if (index->prio[left] > index->prio[right]) {
+        index->right[left] = merge(index, index->right[left], right);
+        index->parent[index->right[left]] = left;
+        update_count(index, left);
+        return left;
+    }
+    index->left[right] = merge(index, left, index->left[right]);
+    index->parent[index->left[right]] = right;
+    update_count(index, right);
+    return right;
+}
+
+// Detaches the nodes first..last (in order) and returns the root of their subtree
+static list_index_t cut_range(list_order_index_t* index, list_index_t first, list_index_t last) {
+    ssize_t first_rank = rank_of(index, first);
+    ssize_t last_rank  = rank_of(index, last);
+
+    list_index_t before = NIL, range = NIL, after = NIL;
+    split(index, index->root, first_rank, &before, &range);
+    if (range != NIL) index->parent[range] = NIL;
+    split(index, range, last_rank - first_rank + 1, &range, &after);
+    if (before != NIL) index->parent[before] = NIL;
+    if (after  != NIL) index->parent[after]  = NIL;
+    if (range  != NIL) index->parent[range]  = NIL;
+
+    index->root = merge(index, before, after);
+    if (index->root != NIL) index->parent[index->root] = NIL;
+    return range;
+}
+
+static bool resize_array(void** array, size_t count, size_t elem_size) {
+    void* block = realloc(*array, count * elem_size);
+    if (block == nullptr) {
+        return false;
+    }
+    *array = block;
+    return true;
+}
+
+//==============================================================================
+
+error_code list_order_index_enable(list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Enabling order index");
+
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Order index is not available for lists in a node pool");
+        return ERROR_INCORRECT_ARGS;
+    }
+    if (list->order_index != nullptr) {
+        return ERROR_NO;
+    }
+    list_order_index_t* index = (list_order_index_t*)calloc(1, sizeof(list_order_index_t));
+    if (index == nullptr) {
+        LOGGER_ERROR("calloc failed for order index");
+        return ERROR_MEM_ALLOC;
+    }
+    index->seed = 0x2545F4914F6CDD1Dull ^ (uint64_t)(size_t)list;
+    list->order_index = index;
+
+    error_code error = order_index_reserve(list, list->capacity);
+    if (error != ERROR_NO) {
+        list_order_index_disable(list);
+        return error;
+    }
+    index->left[NIL] = index->right[NIL] = index->parent[NIL] = index->count[NIL] = NIL;
+    rebuild(list);
+    return ERROR_NO;
+}
+
+void list_order_index_disable(list_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr) {
+        return;
+    }
+    LOGGER_DEBUG("Disabling order index");
+    free(index->left);
+    free(index->right);
+    free(index->parent);
+    free(index->count);
+    free(index->prio);
+    free(index);
+    list->order_index = nullptr;
+}
+
+ssize_t list_logical_index(list_t* list, ssize_t physical_index) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    if (physical_index <= 0 || (size_t)physical_index >= list->capacity ||
+        list_node_is_free(list, physical_index)) {
+        LOGGER_ERROR("list_logical_index: %d is not a live node", physical_index);
+        return -1;
+    }
+    if ((size_t)physical_index <= list->linear_prefix) {
+        return physical_index - 1;
+    }
+
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr) {
+        ssize_t logical = 0;
+        for (ssize_t cur = list->head; cur != physical_index; cur = node_next(list, cur)) {
+            logical++;
+        }
+        return logical;
+    }
+    if (index->stale) {
+        rebuild(list);
+    }
+
+    return rank_of(index, as_index(physical_index));
+}
+
+//==============================================================================
+
+error_code order_index_reserve(list_t* list, size_t capacity) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr) {
+        return ERROR_NO;
+    }
+    LOGGER_DEBUG("Resizing order index to %lu slots", capacity);
+
+    // Shrinks never fail in a way that matters: the old, bigger block is kept
+    bool ok = true;
+    ok &= resize_array((void**)&index->left,   capacity, sizeof(list_index_t));
+    ok &= resize_array((void**)&index->right,  capacity, sizeof(list_index_t));
+    ok &= resize_array((void**)&index->parent, capacity, sizeof(list_index_t));
+    ok &= resize_array((void**)&index->count,  capacity, sizeof(list_index_t));
+    ok &= resize_array((void**)&index->prio,   capacity, sizeof(uint32_t));
+    if (!ok && capacity > index->capacity) {
+        LOGGER_ERROR("realloc failed for order index");
+        return ERROR_MEM_ALLOC;
+    }
+    index->capacity = capacity;
+    return ERROR_NO;
+}
+
+void order_index_insert_after(list_t* list, ssize_t after_idx, ssize_t idx) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+
+    list_index_t node = as_index(idx);
+    index->left[node]  = NIL;
+    index->right[node] = NIL;
+    index->count[node] = 1;
+    index->prio[node]  = next_prio(index);
+
+    if (index->root == NIL) {
+        index->root         = node;
+        index->parent[node] = NIL;
+        return;
+    }
+
+    list_index_t parent = NIL;
+    if (after_idx == 0) {
+        parent = leftmost(index, index->root);
+        index->left[parent] = node;
+    } else if (index->right[after_idx] == NIL) {
+        parent = as_index(after_idx);
+        index->right[parent] = node;
+    } else {
+        parent = leftmost(index, index->right[after_idx]);
+        index->left[parent] = node;
+    }
+    index->parent[node] = parent;
+
+    for (list_index_t cur = parent; cur != NIL; cur = index->parent[cur]) {
+        index->count[cur]++;
+    }
+    while (index->parent[node] != NIL && index->prio[index->parent[node]] < index->prio[node]) {
+        rotate_up(index, node);
+    }
+}
+
+void order_index_insert_run(list_t* list, ssize_t after_idx, ssize_t first_idx, size_t count) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+    if (count > list->size / RUN_REBUILD_RATIO) {
+        index->stale = true;
+        return;
+    }
+    for (ssize_t cur = first_idx; count > 0; --count) {
+        order_index_insert_after(list, after_idx, cur);
+        after_idx = cur;
+        cur       = node_next(list, cur);
+    }
+}
+
+void order_index_remove(list_t* list, ssize_t idx) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+
+    list_index_t node = as_index(idx);
+    while (index->left[node] != NIL && index->right[node] != NIL) {
+        list_index_t left  = index->left[node];
+        list_index_t right = index->right[node];
+        rotate_up(index, index->prio[left] > index->prio[right] ? left : right);
+    }
+
+    list_index_t child  = index->left[node] != NIL ? index->left[node] : index->right[node];
+    list_index_t parent = index->parent[node];
+    if (child != NIL) {
+        index->parent[child] = parent;
+    }
+    replace_child(index, parent, node, child);
+
+    for (list_index_t cur = parent; cur != NIL; cur = index->parent[cur]) {
+        index->count[cur]--;
+    }
+}
+
+void order_index_remove_range(list_t* list, ssize_t first_idx, ssize_t last_idx) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+    cut_range(index, as_index(first_idx), as_index(last_idx));
+}
+
+void order_index_move_range(list_t* list, ssize_t first_idx, ssize_t last_idx, ssize_t after_idx) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+    list_index_t range = cut_range(index, as_index(first_idx), as_index(last_idx));
+    ssize_t      rank  = after_idx == 0 ? 0 : rank_of(index, as_index(after_idx)) + 1;
+
+    list_index_t before = NIL, after = NIL;
+    split(index, index->root, rank, &before, &after);
+    if (before != NIL) index->parent[before] = NIL;
+    if (after  != NIL) index->parent[after]  = NIL;
+
+    index->root = merge(index, merge(index, before, range), after);
+    index->parent[index->root] = NIL;
+}
+
+// Called after two slots exchanged their contents (a live node may also have
+// moved into a free slot): the tree records follow the nodes, and links held
+// by third nodes or the root are repointed to the new slots.
+void order_index_swap(list_t* list, ssize_t first_idx, ssize_t second_idx) {
+    list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return;
+    }
+
+    const list_index_t ids[2] = {as_index(first_idx), as_index(second_idx)};
+    list_index_t* refs[2][3]  = {};
+    size_t        ref_cnt[2]  = {};
+
+    for (int k = 0; k < 2; ++k) {
+        // the slot held a tree record iff its old contents are live now
+        if (list_node_is_free(list, ids[1 - k])) {
+            continue;
+        }
+        list_index_t node = ids[k];
+        list_index_t parent = index->parent[node];
+        if (parent == NIL) {
+            if (index->root == node) refs[k][ref_cnt[k]++] = &index->root;
+        } else if (parent != ids[0] && parent != ids[1]) {
+            refs[k][ref_cnt[k]++] = index->left[parent] == node ? &index->left[parent] : &index->right[parent];
+        }
+        list_index_t children[2] = {index->left[node], index->right[node]};
+        for (int c = 0; c < 2; ++c) {
+            if (children[c] != NIL && children[c] != ids[0] && children[c] != ids[1]) {
+                refs[k][ref_cnt[k]++] = &index->parent[children[c]];
+            }
+        }
+    }
+
+    list_index_t* arrays[4] = {index->left, index->right, index->parent, index->count};
+    for (int a = 0; a < 4; ++a) {
+        list_index_t tmp     = arrays[a][ids[0]];
+        arrays[a][ids[0]]    = arrays[a][ids[1]];
+        arrays[a][ids[1]]    = tmp;
+    }
+    uint32_t prio      = index->prio[ids[0]];
+    index->prio[ids[0]] = index->prio[ids[1]];
+    index->prio[ids[1]] = prio;
+
+    for (int k = 0; k < 2; ++k) {
+        list_index_t* links[3] = {&index->left[ids[k]], &index->right[ids[k]], &index->parent[ids[k]]};
+        for (int l = 0; l < 3; ++l) {
+            if      (*links[l] == ids[0]) *links[l] = ids[1];
+            else if (*links[l] == ids[1]) *links[l] = ids[0];
+        }
+    }
+    for (int k = 0; k < 2; ++k) {
+        for (size_t r = 0; r < ref_cnt[k]; ++r) {
+            *refs[k][r] = ids[1 - k];
+        }
+    }
+}
+
+void order_index_invalidate(list_t* list) {
+    if (list->order_index != nullptr) {
+        list->order_index->stale = true;
+    }
+}
+
+ssize_t order_index_select(const list_t* list, ssize_t logical_index) {
+    list_order_index_t* index = list->order_index;
+    HARD_ASSERT(index != nullptr, "order index is disabled");
+
+    if (index->stale) {
+        rebuild(list);
+    }
+    list_index_t node = index->root;
+    while (node != NIL) {
+        ssize_t left_count = index->count[index->left[node]];
+        if (logical_index < left_count) {
+            node = index->left[node];
+        } else if (logical_index == left_count) {
+            return node;
+        } else {
+            logical_index -= left_count + 1;
+            node = index->right[node];
+        }
+    }
+    return 0;
+}
+
+error_code order_index_verify(const list_t* list, const char** error_description) {
+    const list_order_index_t* index = list->order_index;
+    if (index == nullptr || index->stale) {
+        return ERROR_NO;
+    }
+    if (index->capacity < list->capacity) {
+        LOGGER_ERROR("order index capacity %lu < list capacity %lu", index->capacity, list->capacity);
+        *error_description = "order index too small";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    if ((size_t)index->count[index->root] != list->size - 1 || index->parent[index->root] != NIL) {
+        LOGGER_ERROR("order index root %ld holds %ld nodes, list has %lu",
+                     (ssize_t)index->root, (ssize_t)index->count[index->root], list->size - 1);
+        *error_description = "order index root mismatch";
+        return ERROR_INVALID_STRUCTURE;
+    }
+
+    const size_t used  = list->untouched;
+    list_index_t tree  = index->root == NIL ? NIL : leftmost(index, index->root);
+    size_t       steps = 0;
+    for (ssize_t cur = list->head; cur != 0 && steps < list->size; cur = node_next(list, cur), ++steps) {
+        list_index_t left  = index->left[cur];
+        list_index_t right = index->right[cur];
+        if ((size_t)left >= used || (size_t)right >= used || left < 0 || right < 0 ||
+            tree != cur ||
+            index->count[cur] != 1 + index->count[left] + index->count[right] ||
+            (left  != NIL && (index->parent[left]  != cur || index->prio[left]  > index->prio[cur])) ||
+            (right != NIL && (index->parent[right] != cur || index->prio[right] > index->prio[cur]))) {
+            LOGGER_ERROR("order index broken at node %ld (logical %lu)", cur, steps);
+            *error_description = "order index broken";
+            return ERROR_INVALID_STRUCTURE;
+        }
+
+        if (right != NIL) {
+            tree = leftmost(index, right);
+        } else {
+            list_index_t node = as_index(cur);
+            tree = index->parent[node];
+            while (tree != NIL && index->right[tree] == node) {
+                node = tree;
+                tree = index->parent[tree];
+            }
+        }
+    }
+    return ERROR_NO;
+}
@@ -0,0 +1,325 @@
+#include "list_reduce.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define LIST_REDUCE_X86
+    #include <immintrin.h>
+#endif
+
+// Distance, in elements, between the val (prev) fields of neighbouring slots
+#ifdef LIST_SOA
+static const size_t VAL_STRIDE  = 1;
+static const size_t PREV_STRIDE = 1;
+#else
+static const size_t VAL_STRIDE  = sizeof(node_t) / sizeof(double);
+static const size_t PREV_STRIDE = sizeof(node_t) / sizeof(list_index_t);
+static_assert(sizeof(node_t) % sizeof(double) == 0 && sizeof(node_t) % sizeof(list_index_t) == 0,
+              "node_t fields must tile the node");
+#endif
+
+// Every public reduction is answered from one pass that gathers all of
+// these; the scan is bound by the loads, not by the extra lanes of work
+struct value_stats_t {
+    double sum;
+    double min;
+    double max;
+    size_t live;
+    size_t in_range;
+};
+
+typedef void (*stats_kernel_t)(const double* val, const list_index_t* prev, size_t count,
+                               double lo, double hi, value_stats_t* stats);
+
+// Set bits of a movemask; __builtin_popcount is a libcall without -mpopcnt
+static const uint8_t MASK_BITS[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+static int simd_forced = -1;  // list_simd_force cap, -1 for none
+static int simd_cpu    = -1;  // best level the CPU has, -1 until detected
+
+//==============================================================================
+
+static inline bool is_poison(double val);
+static inline void add_value(value_stats_t* stats, double val, double lo, double hi);
+static void stats_scalar(const double* val, const list_index_t* prev, size_t count,
+                         double lo, double hi, value_stats_t* stats);
+#ifdef LIST_REDUCE_X86
+static void stats_sse2(const double* val, const list_index_t* prev, size_t count,
+                       double lo, double hi, value_stats_t* stats);
+static void stats_avx2(const double* val, const list_index_t* prev, size_t count,
+                       double lo, double hi, value_stats_t* stats);
+#endif
+static list_simd_level_t cpu_simd_level();
+static stats_kernel_t    pick_kernel();
+static void              collect_stats(const list_t* list, double lo, double hi, value_stats_t* stats);
+
+//==============================================================================
+
+// Bitwise, so that the check does not trip -Wfloat-equal; -100.0 has one encoding
+static inline bool is_poison(double val) {
+    const double poison = (double)POISON;
+    return memcmp(&val, &poison, sizeof(double)) == 0;
+}
+
+static inline void add_value(value_stats_t* stats, double val, double lo, double hi) {
+    stats->sum += val;
+    stats->live++;
+    if (val < stats->min) stats->min = val;
+    if (val > stats->max) stats->max = val;
+    if (lo <= val && val <= hi) stats->in_range++;
+}
+
+static void stats_scalar(const double* val, const list_index_t* prev, size_t count,
+                         double lo, double hi, value_stats_t* stats) {
+    for (size_t i = 0; i < count; ++i) {
+        double v = val[i * VAL_STRIDE];
+        if (prev[i * PREV_STRIDE] != POISON && !is_poison(v)) {
+            add_value(stats, v, lo, hi);
+        }
+    }
+}
+
+#ifdef LIST_REDUCE_X86
+
+// Lanes are masked rather than branched on: a free slot adds 0 to the sum,
+// +inf / -inf to min / max and nothing to the counts. min / max take the new
+// value as the first operand, so a NaN leaves the running result alone.
+__attribute__((target("sse2")))
+static void stats_sse2(const double* val, const list_index_t* prev, size_t count,
+                       double lo, double hi, value_stats_t* stats) {
+    const __m128d poison_val  = _mm_set1_pd((double)POISON);
+    const __m128i poison_prev = _mm_set1_epi64x(POISON);
+    const __m128d pos_inf     = _mm_set1_pd(INFINITY);
+    const __m128d neg_inf     = _mm_set1_pd(-INFINITY);
+    const __m128d lo_v        = _mm_set1_pd(lo);
+    const __m128d hi_v        = _mm_set1_pd(hi);
+
+    __m128d sum = _mm_setzero_pd();
+    __m128d min = pos_inf;
+    __m128d max = neg_inf;
+    size_t  live     = 0;
+    size_t  in_range = 0;
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d v = VAL_STRIDE == 1 ? _mm_loadu_pd(val + i)
+                                    : _mm_set_pd(val[(i + 1) * VAL_STRIDE], val[i * VAL_STRIDE]);
+        __m128i p;
+        if (PREV_STRIDE == 1 && sizeof(list_index_t) == sizeof(int64_t)) {
+            p = _mm_loadu_si128((const __m128i*)(const void*)(prev + i));
+        } else if (PREV_STRIDE == 1) {
+            __m128i narrow = _mm_loadl_epi64((const __m128i*)(const void*)(prev + i));
+            p = _mm_unpacklo_epi32(narrow, _mm_srai_epi32(narrow, 31));
+        } else {
+            p = _mm_set_epi64x((long long)prev[(i + 1) * PREV_STRIDE], (long long)prev[i * PREV_STRIDE]);
+        }
+        // no 64-bit compare before SSE4.1: both 32-bit halves must match
+        __m128i p_eq = _mm_cmpeq_epi32(p, poison_prev);
+        p_eq = _mm_and_si128(p_eq, _mm_shuffle_epi32(p_eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128d dead = _mm_or_pd(_mm_castsi128_pd(p_eq), _mm_cmpeq_pd(v, poison_val));
+
+        __m128d v_live = _mm_andnot_pd(dead, v);
+        sum = _mm_add_pd(sum, v_live);
+        min = _mm_min_pd(_mm_or_pd(v_live, _mm_and_pd(dead, pos_inf)), min);
+        max = _mm_max_pd(_mm_or_pd(v_live, _mm_and_pd(dead, neg_inf)), max);
+
+        __m128d inside = _mm_and_pd(_mm_cmple_pd(lo_v, v), _mm_cmple_pd(v, hi_v));
+        live     += MASK_BITS[~_mm_movemask_pd(dead) & 0x3];
+        in_range += MASK_BITS[_mm_movemask_pd(_mm_andnot_pd(dead, inside))];
+    }
+
+    double lanes_sum[2], lanes_min[2], lanes_max[2];
+    _mm_storeu_pd(lanes_sum, sum);
+    _mm_storeu_pd(lanes_min, min);
+    _mm_storeu_pd(lanes_max, max);
+    stats->sum      += lanes_sum[0] + lanes_sum[1];
+    stats->min       = fmin(stats->min, fmin(lanes_min[0], lanes_min[1]));
+    stats->max       = fmax(stats->max, fmax(lanes_max[0], lanes_max[1]));
+    stats->live     += live;
+    stats->in_range += in_range;
+
+    stats_scalar(val + i * VAL_STRIDE, prev + i * PREV_STRIDE, count - i, lo, hi, stats);
+}
+
+__attribute__((target("avx2")))
+static void stats_avx2(const double* val, const list_index_t* prev, size_t count,
+                       double lo, double hi, value_stats_t* stats) {
+    const __m256d poison_val  = _mm256_set1_pd((double)POISON);
+    const __m256i poison_prev = _mm256_set1_epi64x(POISON);
+    const __m256d pos_inf     = _mm256_set1_pd(INFINITY);
+    const __m256d neg_inf     = _mm256_set1_pd(-INFINITY);
+    const __m256d lo_v        = _mm256_set1_pd(lo);
+    const __m256d hi_v        = _mm256_set1_pd(hi);
+
+    __m256d sum = _mm256_setzero_pd();
+    __m256d min = pos_inf;
+    __m256d max = neg_inf;
+    size_t  live     = 0;
+    size_t  in_range = 0;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d v;
+        if (VAL_STRIDE == 1) {
+            v = _mm256_loadu_pd(val + i);
+        } else {
+            v = _mm256_set_pd(val[(i + 3) * VAL_STRIDE], val[(i + 2) * VAL_STRIDE],
+                              val[(i + 1) * VAL_STRIDE], val[i * VAL_STRIDE]);
+        }
+        __m256i p;
+        if (PREV_STRIDE == 1 && sizeof(list_index_t) == sizeof(int64_t)) {
+            p = _mm256_loadu_si256((const __m256i*)(const void*)(prev + i));
+        } else if (PREV_STRIDE == 1) {
+            p = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(const void*)(prev + i)));
+        } else {
+            p = _mm256_set_epi64x((long long)prev[(i + 3) * PREV_STRIDE], (long long)prev[(i + 2) * PREV_STRIDE],
+                                  (long long)prev[(i + 1) * PREV_STRIDE], (long long)prev[i * PREV_STRIDE]);
+        }
+        __m256d dead = _mm256_or_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(p, poison_prev)),
+                                    _mm256_cmp_pd(v, poison_val, _CMP_EQ_OQ));
+
+        __m256d v_live = _mm256_andnot_pd(dead, v);
+        sum = _mm256_add_pd(sum, v_live);
+        min = _mm256_min_pd(_mm256_or_pd(v_live, _mm256_and_pd(dead, pos_inf)), min);
+        max = _mm256_max_pd(_mm256_or_pd(v_live, _mm256_and_pd(dead, neg_inf)), max);
+
+        __m256d inside = _mm256_and_pd(_mm256_cmp_pd(lo_v, v, _CMP_LE_OQ), _mm256_cmp_pd(v, hi_v, _CMP_LE_OQ));
+        live     += MASK_BITS[~_mm256_movemask_pd(dead) & 0xF];
+        in_range += MASK_BITS[_mm256_movemask_pd(_mm256_andnot_pd(dead, inside))];
+    }
+
+    double lanes_sum[4], lanes_min[4], lanes_max[4];
+    _mm256_storeu_pd(lanes_sum, sum);
+    _mm256_storeu_pd(lanes_min, min);
+    _mm256_storeu_pd(lanes_max, max);
+    stats->sum += (lanes_sum[0] + lanes_sum[1]) + (lanes_sum[2] + lanes_sum[3]);
+    stats->min  = fmin(stats->min, fmin(fmin(lanes_min[0], lanes_min[1]), fmin(lanes_min[2], lanes_min[3])));
+    stats->max  = fmax(stats->max, fmax(fmax(lanes_max[0], lanes_max[1]), fmax(lanes_max[2], lanes_max[3])));
+    stats->live     += live;
+    stats->in_range += in_range;
+
+    stats_scalar(val + i * VAL_STRIDE, prev + i * PREV_STRIDE, count - i, lo, hi, stats);
+}
+
+#endif
+
+static list_simd_level_t cpu_simd_level() {
+    if (simd_cpu == -1) {
+        simd_cpu = LIST_SIMD_SCALAR;
+#ifdef LIST_REDUCE_X86
+        __builtin_cpu_init();
+        if      (__builtin_cpu_supports("avx2")) simd_cpu = LIST_SIMD_AVX2;
+        else if (__builtin_cpu_supports("sse2")) simd_cpu = LIST_SIMD_SSE2;
+#endif
+        LOGGER_DEBUG("Reductions use SIMD level %d", simd_cpu);
+    }
+    return (list_simd_level_t)simd_cpu;
+}
+
+static stats_kernel_t pick_kernel() {
+    switch (list_simd_level()) {
+#ifdef LIST_REDUCE_X86
+        case LIST_SIMD_AVX2:   return stats_avx2;
+        case LIST_SIMD_SSE2:   return stats_sse2;
+#else
+        case LIST_SIMD_AVX2:
+        case LIST_SIMD_SSE2:
+#endif
+        case LIST_SIMD_SCALAR:
+        default:               return stats_scalar;
+    }
+}
+
+static void collect_stats(const list_t* list, double lo, double hi, value_stats_t* stats) {
+    *stats = {0.0, INFINITY, -INFINITY, 0, 0};
+
+    if (list->pool != nullptr) {
+        for (ssize_t cur = node_next(list, 0); cur != 0; cur = node_next(list, cur)) {
+            double val = node_val(list, cur);
+            if (!is_poison(val)) {
+                add_value(stats, val, lo, hi);
+            }
+        }
+        return;
+    }
+
+    stats_kernel_t kernel = pick_kernel();
+    const size_t   end    = list_is_linear(list) ? list->size : list->untouched;
+    for (size_t first = 1; first < end; ) {
+        size_t last = end;
+        if (list->chunks != nullptr) {
+            size_t chunk_end = (first | (LIST_CHUNK_NODES - 1)) + 1;
+            if (chunk_end < last) last = chunk_end;
+        }
+        kernel(&node_val(list, (ssize_t)first), &node_prev(list, (ssize_t)first), last - first, lo, hi, stats);
+        first = last;
+    }
+}
+
+//==============================================================================
+
+list_simd_level_t list_simd_level() {
+    list_simd_level_t level = cpu_simd_level();
+    if (simd_forced != -1 && simd_forced < (int)level) {
+        level = (list_simd_level_t)simd_forced;
+    }
+    return level;
+}
+
+list_simd_level_t list_simd_force(list_simd_level_t level) {
+    simd_forced = (int)level;
+    return list_simd_level();
+}
+
+double list_reduce_sum(const list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    value_stats_t stats = {};
+    collect_stats(list, 0.0, 0.0, &stats);
+    return stats.sum;
+}
+
+error_code list_min(const list_t* list, double* min_return) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    HARD_ASSERT(min_return != nullptr, "min_return is nullptr");
+
+    value_stats_t stats = {};
+    collect_stats(list, 0.0, 0.0, &stats);
+    if (stats.live == 0) {
+        LOGGER_DEBUG("list_min: list is empty");
+        return ERROR_MISSED_ELEM;
+    }
+    *min_return = stats.min;
+    return ERROR_NO;
+}
+
+error_code list_max(const list_t* list, double* max_return) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    HARD_ASSERT(max_return != nullptr, "max_return is nullptr");
+
+    value_stats_t stats = {};
+    collect_stats(list, 0.0, 0.0, &stats);
+    if (stats.live == 0) {
+        LOGGER_DEBUG("list_max: list is empty");
+        return ERROR_MISSED_ELEM;
+    }
+    *max_return = stats.max;
+    return ERROR_NO;
+}
+
+size_t list_count_if_range(const list_t* list, double lo, double hi) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    value_stats_t stats = {};
+    collect_stats(list, lo, hi, &stats);
+    return stats.in_range;
+}
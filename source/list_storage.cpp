@@ -0,0 +1,491 @@
+#include "list_storage.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//==============================================================================
+
+static void*      mem_alloc    (const list_t* list, size_t bytes);
+static void*      mem_realloc  (const list_t* list, void* block, size_t old_bytes, size_t new_bytes);
+static void       mem_free     (const list_t* list, void* block, size_t bytes);
+static size_t     alloc_slots  (size_t capacity);
+static size_t     chunks_for   (size_t capacity);
+static error_code chunks_resize(list_t* list, size_t new_capacity);
+//------------------------------------------------------------------------------
+struct storage_block_t {
+    void** ptr;
+    size_t elem_size;
+    void*  inline_block;  // the list_t's own slots for this array, nullptr if none
+};
+
+static bool       is_mapped     (const list_t* list);
+static size_t     storage_blocks(list_t* list, storage_block_t* blocks);
+static size_t     inline_slots  ();
+static bool       fits_inline   (size_t slots);
+static void       block_free    (const list_t* list, const storage_block_t* block, size_t slots);
+static void*      block_realloc (const list_t* list, const storage_block_t* block, size_t old_slots, size_t new_slots);
+static error_code mapped_alloc  (list_t* list, size_t capacity);
+static error_code mapped_resize (list_t* list, size_t new_capacity);
+static void       mapped_free   (list_t* list);
+
+//==============================================================================
+
+// Every non-mapped block goes through the list's allocator descriptor
+static void* mem_alloc(const list_t* list, size_t bytes) {
+    if (list->allocator.alloc == nullptr) return malloc(bytes);
+    return list->allocator.alloc(list->allocator.ctx, bytes);
+}
+
+static void* mem_realloc(const list_t* list, void* block, size_t old_bytes, size_t new_bytes) {
+    if (list->allocator.alloc == nullptr) return realloc(block, new_bytes);
+    return list->allocator.realloc(list->allocator.ctx, block, old_bytes, new_bytes);
+}
+
+static void mem_free(const list_t* list, void* block, size_t bytes) {
+    if (block == nullptr) return;
+    if (list->allocator.alloc == nullptr) {
+        free(block);
+        return;
+    }
+    list->allocator.free(list->allocator.ctx, block, bytes);
+}
+
+static size_t alloc_slots(size_t capacity) {
+    return capacity ON_DEBUG(+ 1);
+}
+
+static size_t chunks_for(size_t capacity) {
+    return (alloc_slots(capacity) + LIST_CHUNK_NODES - 1) >> LIST_CHUNK_SHIFT;
+}
+
+// Adds or frees whole chunks; existing chunks never move. A failed grow
+// keeps the chunks that were added, which is harmless since capacity stays.
+static error_code chunks_resize(list_t* list, size_t new_capacity) {
+    size_t needed = chunks_for(new_capacity);
+    LOGGER_DEBUG("Resizing chunked storage from %lu to %lu chunks", list->chunk_count, needed);
+
+    if (needed > list->chunk_dir_capacity) {
+        size_t dir_capacity = list->chunk_dir_capacity * 2;
+        if (dir_capacity < needed) dir_capacity = needed;
+
+        node_chunk_t** dir = (node_chunk_t**)mem_realloc(list, list->chunks,
+                                                         list->chunk_dir_capacity * sizeof(node_chunk_t*),
+                                                         dir_capacity * sizeof(node_chunk_t*));
+        if (dir == nullptr) {
+            LOGGER_ERROR("Realloc failed for chunk directory");
+            return ERROR_MEM_ALLOC;
+        }
+        list->chunks             = dir;
+        list->chunk_dir_capacity = dir_capacity;
+    }
+    while (list->chunk_count < needed) {
+        node_chunk_t* chunk = (node_chunk_t*)mem_alloc(list, sizeof(node_chunk_t));
+        if (chunk == nullptr) {
+            LOGGER_ERROR("Malloc failed for node chunk");
+            return ERROR_MEM_ALLOC;
+        }
+        list->chunks[list->chunk_count++] = chunk;
+    }
+    while (list->chunk_count > needed) {
+        mem_free(list, list->chunks[--list->chunk_count], sizeof(node_chunk_t));
+    }
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+static bool is_mapped(const list_t* list) {
+    return list->storage_kind == LIST_STORAGE_MAPPED || list->storage_kind == LIST_STORAGE_MAPPED_HUGE;
+}
+
+static size_t storage_blocks(list_t* list, storage_block_t* blocks) {
+#ifdef LIST_INLINE_NODES
+#ifdef LIST_SOA
+    blocks[0] = {(void**)&list->next, sizeof(list_index_t), list->inline_next};
+    blocks[1] = {(void**)&list->prev, sizeof(list_index_t), list->inline_prev};
+    blocks[2] = {(void**)&list->val,  sizeof(double),       list->inline_val};
+    return 3;
+#else
+    blocks[0] = {(void**)&list->arr, sizeof(node_t), list->inline_nodes};
+    return 1;
+#endif
+#else
+#ifdef LIST_SOA
+    blocks[0] = {(void**)&list->next, sizeof(list_index_t), nullptr};
+    blocks[1] = {(void**)&list->prev, sizeof(list_index_t), nullptr};
+    blocks[2] = {(void**)&list->val,  sizeof(double),       nullptr};
+    return 3;
+#else
+    blocks[0] = {(void**)&list->arr, sizeof(node_t), nullptr};
+    return 1;
+#endif
+#endif
+}
+
+static size_t inline_slots() {
+#ifdef LIST_INLINE_NODES
+    return LIST_INLINE_SLOTS;
+#else
+    return 0;
+#endif
+}
+
+static bool fits_inline(size_t slots) {
+    return inline_slots() != 0 && slots <= inline_slots();
+}
+
+// Inline slots never go through the allocator
+static void block_free(const list_t* list, const storage_block_t* block, size_t slots) {
+    if (*block->ptr != block->inline_block) {
+        mem_free(list, *block->ptr, slots * block->elem_size);
+    }
+    *block->ptr = nullptr;
+}
+
+// Moves an inline block out to the heap once it is outgrown; a heap block
+// stays on the heap.
+static void* block_realloc(const list_t* list, const storage_block_t* block, size_t old_slots, size_t new_slots) {
+    if (*block->ptr != block->inline_block) {
+        return mem_realloc(list, *block->ptr, old_slots * block->elem_size, new_slots * block->elem_size);
+    }
+    if (fits_inline(new_slots)) {
+        return *block->ptr;
+    }
+    void* heap = mem_alloc(list, new_slots * block->elem_size);
+    if (heap != nullptr) {
+        memcpy(heap, block->inline_block, old_slots * block->elem_size);
+    }
+    return heap;
+}
+
+#ifdef __linux__
+
+// Address space reserved up front, per array: MAPPED_RESERVE_FACTOR times the
+// requested capacity, kept within [MAPPED_RESERVE_MIN, MAPPED_RESERVE_MAX]
+// slots. Pages are only backed once touched; past the reservation mremap
+// doubles it.
+static const size_t MAPPED_RESERVE_FACTOR = 16;
+static const size_t MAPPED_RESERVE_MIN    = (size_t)1 << 16;
+static const size_t MAPPED_RESERVE_MAX    = (size_t)1 << 24;
+
+static size_t page_round(size_t bytes) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+}
+
+static void* map_block(size_t bytes, bool huge) {
+    void* block = mmap(nullptr, page_round(bytes), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        return nullptr;
+    }
+    if (huge && madvise(block, page_round(bytes), MADV_HUGEPAGE) != 0) {
+        LOGGER_WARNING("MADV_HUGEPAGE refused, continuing with normal pages");
+    }
+    return block;
+}
+
+static error_code mapped_alloc(list_t* list, size_t capacity) {
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    bool   huge        = list->storage_kind == LIST_STORAGE_MAPPED_HUGE;
+
+    size_t slots   = alloc_slots(capacity);
+    size_t reserve = slots * MAPPED_RESERVE_FACTOR;
+    if (reserve < MAPPED_RESERVE_MIN) reserve = MAPPED_RESERVE_MIN;
+    if (reserve > MAPPED_RESERVE_MAX) reserve = MAPPED_RESERVE_MAX;
+    if (reserve < slots)              reserve = slots;
+    // A big reservation may be refused (strict overcommit, ulimit -v): then
+    // map exactly what is needed and let mremap do the growing.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool ok = true;
+        for (size_t i = 0; i < block_count; ++i) {
+            *blocks[i].ptr = map_block(reserve * blocks[i].elem_size, huge);
+            ok &= *blocks[i].ptr != nullptr;
+        }
+        if (ok) {
+            list->mapped_slots = reserve;
+            return ERROR_NO;
+        }
+        for (size_t i = 0; i < block_count; ++i) {
+            if (*blocks[i].ptr != nullptr) munmap(*blocks[i].ptr, page_round(reserve * blocks[i].elem_size));
+            *blocks[i].ptr = nullptr;
+        }
+        LOGGER_WARNING("Could not reserve %lu mapped slots", reserve);
+        reserve = slots;
+    }
+    LOGGER_ERROR("mmap failed during storage allocation");
+    return ERROR_MEM_ALLOC;
+}
+
+static error_code mapped_resize(list_t* list, size_t new_capacity) {
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+
+    size_t old_slots = alloc_slots(list->capacity);
+    size_t new_slots = alloc_slots(new_capacity);
+
+    if (new_slots > list->mapped_slots) {
+        size_t reserve = list->mapped_slots * 2;
+        if (reserve < new_slots) reserve = new_slots;
+        LOGGER_DEBUG("Remapping storage to %lu slots", reserve);
+
+        // mremap moves page tables, never node contents
+        size_t done = 0;
+        for (; done < block_count; ++done) {
+            void* block = mremap(*blocks[done].ptr, page_round(list->mapped_slots * blocks[done].elem_size),
+                                 page_round(reserve * blocks[done].elem_size), MREMAP_MAYMOVE);
+            if (block == MAP_FAILED) break;
+            *blocks[done].ptr = block;
+            if (list->storage_kind == LIST_STORAGE_MAPPED_HUGE) {
+                madvise(block, page_round(reserve * blocks[done].elem_size), MADV_HUGEPAGE);
+            }
+        }
+        if (done < block_count) {
+            LOGGER_ERROR("mremap failed");
+            for (size_t i = 0; i < done; ++i) {
+                void* block = mremap(*blocks[i].ptr, page_round(reserve * blocks[i].elem_size),
+                                     page_round(list->mapped_slots * blocks[i].elem_size), 0);
+                HARD_ASSERT(block != MAP_FAILED, "shrinking mremap failed");
+                (void)block;
+            }
+            return ERROR_MEM_ALLOC;
+        }
+        list->mapped_slots = reserve;
+    } else if (new_slots < old_slots) {
+        // Pages wholly past the new end go back to the kernel and come back
+        // zeroed if the list grows again.
+        for (size_t i = 0; i < block_count; ++i) {
+            size_t keep = page_round(new_slots * blocks[i].elem_size);
+            size_t used = page_round(old_slots * blocks[i].elem_size);
+            if (used > keep) {
+                madvise((char*)*blocks[i].ptr + keep, used - keep, MADV_DONTNEED);
+            }
+        }
+    }
+    return ERROR_NO;
+}
+
+static void mapped_free(list_t* list) {
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    for (size_t i = 0; i < block_count; ++i) {
+        if (*blocks[i].ptr != nullptr) {
+            munmap(*blocks[i].ptr, page_round(list->mapped_slots * blocks[i].elem_size));
+        }
+        *blocks[i].ptr = nullptr;
+    }
+    list->mapped_slots = 0;
+}
+
+#else
+
+// No mmap backend here: mapped kinds quietly use malloc'd flat storage
+static error_code mapped_alloc(list_t* list, size_t capacity) {
+    LOGGER_WARNING("Mapped storage unsupported on this platform, using flat storage");
+    list->storage_kind = LIST_STORAGE_FLAT;
+    return list_storage_alloc(list, capacity);
+}
+
+static error_code mapped_resize(list_t*, size_t) {
+    return ERROR_MEM_ALLOC;
+}
+
+static void mapped_free(list_t*) {
+}
+
+#endif
+
+//==============================================================================
+
+
+//==============================================================================
+
+error_code list_storage_alloc(list_t* list, size_t capacity) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    size_t alloc_count = alloc_slots(capacity);
+    LOGGER_DEBUG("Allocating %lu nodes", alloc_count);
+    if (list->storage_kind == LIST_STORAGE_CHUNKED) {
+        error_code error = chunks_resize(list, capacity);
+        if (error != ERROR_NO) {
+            list_storage_free(list);
+        }
+        return error;
+    }
+    if (is_mapped(list)) {
+        return mapped_alloc(list, capacity);
+    }
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    bool   ok          = true;
+    for (size_t i = 0; i < block_count; ++i) {
+        if (blocks[i].inline_block != nullptr && fits_inline(alloc_count)) {
+            *blocks[i].ptr = blocks[i].inline_block;
+            continue;
+        }
+        *blocks[i].ptr = mem_alloc(list, alloc_count * blocks[i].elem_size);
+        ok &= *blocks[i].ptr != nullptr;
+    }
+    if (!ok) {
+        LOGGER_ERROR("Allocation failed during storage allocation");
+        for (size_t i = 0; i < block_count; ++i) {
+            block_free(list, &blocks[i], alloc_count);
+        }
+        return ERROR_MEM_ALLOC;
+    }
+    return ERROR_NO;
+}
+
+error_code list_storage_resize(list_t* list, size_t new_capacity) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    if (list->storage_kind == LIST_STORAGE_CHUNKED) {
+        return chunks_resize(list, new_capacity);
+    }
+    if (is_mapped(list)) {
+        return mapped_resize(list, new_capacity);
+    }
+
+    size_t old_count = alloc_slots(list->capacity);
+    size_t new_count = alloc_slots(new_capacity);
+
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    size_t done        = 0;
+    for (; done < block_count; ++done) {
+        LOGGER_DEBUG("Reallocating %lu bytes for list", new_count * blocks[done].elem_size);
+        void* block = block_realloc(list, &blocks[done], old_count, new_count);
+        if (block == nullptr) break;
+        *blocks[done].ptr = block;
+    }
+    if (done < block_count) {
+        // Blocks must keep agreeing with capacity, since the allocator is told
+        // their size on free: put the ones already resized back.
+        LOGGER_ERROR("Realloc failed");
+        for (size_t i = 0; i < done; ++i) {
+            if (*blocks[i].ptr == blocks[i].inline_block) continue;
+            void* block = mem_realloc(list, *blocks[i].ptr, new_count * blocks[i].elem_size,
+                                                            old_count * blocks[i].elem_size);
+            if (block == nullptr) {
+                LOGGER_ERROR("Could not undo a partial resize, storage sizes are now inconsistent");
+                continue;
+            }
+            *blocks[i].ptr = block;
+        }
+        return ERROR_MEM_ALLOC;
+    }
+    return ERROR_NO;
+}
+
+void list_storage_free(list_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    for (size_t i = 0; i < list->chunk_count; ++i) {
+        mem_free(list, list->chunks[i], sizeof(node_chunk_t));
+    }
+    mem_free(list, list->chunks, list->chunk_dir_capacity * sizeof(node_chunk_t*));
+    list->chunks             = nullptr;
+    list->chunk_count        = 0;
+    list->chunk_dir_capacity = 0;
+    if (list->mapped_slots != 0) {
+        mapped_free(list);
+        return;
+    }
+    storage_block_t blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    for (size_t i = 0; i < block_count; ++i) {
+        block_free(list, &blocks[i], alloc_slots(list->capacity));
+    }
+}
+
+void list_storage_swap(list_t* first, list_t* second) {
+    HARD_ASSERT(first != nullptr && second != nullptr, "list is nullptr");
+    HARD_ASSERT(first->storage_kind == second->storage_kind, "storage kinds differ");
+
+    node_chunk_t** chunks       = first->chunks;
+    size_t         chunk_count  = first->chunk_count;
+    size_t         dir_capacity = first->chunk_dir_capacity;
+    first->chunks              = second->chunks;
+    first->chunk_count         = second->chunk_count;
+    first->chunk_dir_capacity  = second->chunk_dir_capacity;
+    second->chunks             = chunks;
+    second->chunk_count        = chunk_count;
+    second->chunk_dir_capacity = dir_capacity;
+
+    size_t mapped_slots  = first->mapped_slots;
+    first->mapped_slots  = second->mapped_slots;
+    second->mapped_slots = mapped_slots;
+
+    // Inline slots cannot change owners: their contents are exchanged instead
+    // and each pointer keeps referring to its own list's buffer.
+    storage_block_t first_blocks[3]  = {};
+    storage_block_t second_blocks[3] = {};
+    size_t block_count = storage_blocks(first, first_blocks);
+    storage_blocks(second, second_blocks);
+    for (size_t i = 0; i < block_count; ++i) {
+        const storage_block_t& a = first_blocks[i];
+        const storage_block_t& b = second_blocks[i];
+        void* a_block = *a.ptr;
+        void* b_block = *b.ptr;
+        bool  a_in    = a_block != nullptr && a_block == a.inline_block;
+        bool  b_in    = b_block != nullptr && b_block == b.inline_block;
+        if (a_in || b_in) {
+            char* a_bytes = (char*)a.inline_block;
+            char* b_bytes = (char*)b.inline_block;
+            for (size_t k = 0; k < inline_slots() * a.elem_size; ++k) {
+                char tmp   = a_bytes[k];
+                a_bytes[k] = b_bytes[k];
+                b_bytes[k] = tmp;
+            }
+        }
+        *a.ptr = b_in ? a.inline_block : b_block;
+        *b.ptr = a_in ? b.inline_block : a_block;
+    }
+}
+
+void list_storage_relocate(list_t* list, list_t* from) {
+    HARD_ASSERT(list != nullptr && from != nullptr, "list is nullptr");
+
+    storage_block_t blocks[3]      = {};
+    storage_block_t from_blocks[3] = {};
+    size_t block_count = storage_blocks(list, blocks);
+    storage_blocks(from, from_blocks);
+    for (size_t i = 0; i < block_count; ++i) {
+        if (*blocks[i].ptr != nullptr && *blocks[i].ptr == from_blocks[i].inline_block) {
+            *blocks[i].ptr = blocks[i].inline_block;
+        }
+    }
+}
+
+size_t list_storage_fit_capacity(const list_t* list, size_t capacity) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (list->storage_kind == LIST_STORAGE_FLAT && fits_inline(alloc_slots(capacity))) {
+        return inline_slots() - alloc_slots(0);
+    }
+    if (list->storage_kind != LIST_STORAGE_CHUNKED) {
+        return capacity;
+    }
+    size_t fitted = (chunks_for(capacity) << LIST_CHUNK_SHIFT) - alloc_slots(0);
+    return fitted > LIST_MAX_CAPACITY ? LIST_MAX_CAPACITY : fitted;
+}
+
+size_t list_storage_grow_capacity(const list_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (list->storage_kind == LIST_STORAGE_CHUNKED) {
+        return list_storage_fit_capacity(list, list->capacity + LIST_CHUNK_NODES);
+    }
+    return (size_t)((double)list->capacity * GROWTH_FACTOR);
+}
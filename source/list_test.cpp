@@ -1,3 +1,920 @@
 #include "list_info.h"
+#include "list_operations.h"
+#include "list_verification.h"
+#include "list_order_index.h"
+#include "list_handles.h"
+#include "list_value_index.h"
+#include "list_lru.h"
+#include "list_unrolled.h"
+#include "list_reduce.h"
+#include "list_template.h"
+#include "logger.h"
+#include "error_handler.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
+// Self-checks (`make test`). Every check runs a random sequence of
+// operations against a std::vector of keys and compares the list with it
+// after each step; list_verify checks the slot, arena and index invariants
+// on top of that.
+
+static const int    TEST_OPS          = 4000;
+static const int    TEST_SWAP_EVERY   = 7;
+static const int    TEST_LINEAR_EVERY = 331;
+static const int    TEST_SHRINK_EVERY = 997;
+static const size_t TEST_MAX_ELEMS    = 300;
+static const size_t PAYLOAD_BYTES     = 256;
+
+// Trivially copyable, big enough that the arena layout matters
+struct test_payload_t {
+    long key;
+    char pad[PAYLOAD_BYTES - sizeof(long)];
+};
+
+//==============================================================================
+// Payload types: a key goes in, the same key comes back out
+
+static void set_key(double* val, long key)         { *val = (double)key; }
+static void set_key(std::string* val, long key)    { *val = "payload #" + std::to_string(key); }
+static void set_key(test_payload_t* val, long key) { val->key = key; val->pad[PAYLOAD_BYTES - sizeof(long) - 1] = (char)key; }
+
+static long get_key(const double& val)         { return (long)val; }
+static long get_key(const std::string& val)    { return strtol(val.c_str() + sizeof("payload #") - 1, nullptr, 10); }
+static long get_key(const test_payload_t& val) {
+    return val.pad[PAYLOAD_BYTES - sizeof(long) - 1] == (char)val.key ? val.key : -1;
+}
+
+static uint64_t rand_next(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+//==============================================================================
+
+template <typename List>
+static bool same_as(const List* list, const std::vector<long>& expected) {
+    if (list_verify(list) != ERROR_NO || list->size - 1 != expected.size()) {
+        return false;
+    }
+    ssize_t cur = list->head;
+    for (long key : expected) {
+        if (get_key(tlist_val(list, cur)) != key) {
+            return false;
+        }
+        cur = tlist_next(list, cur);
+    }
+    return true;
+}
+
+// After linearize logical i sits in slot i + 1, and in arena[i] if there is one
+template <typename List>
+static bool is_linear(const List* list) {
+    for (size_t i = 1; i < list->size; ++i) {
+        if (tlist_prev(list, (ssize_t)i) != (ssize_t)i - 1) {
+            return false;
+        }
+        if constexpr (List::out_of_line) {
+            if (list->nodes[i].slot != i - 1) return false;
+        }
+    }
+    return list->untouched == list->size && list->free_head == -1;
+}
+
+template <typename List>
+static bool is_trimmed(const List* list) {
+    size_t target = list->size < MIN_LIST_SIZE ? MIN_LIST_SIZE : list->size;
+    if constexpr (List::out_of_line) {
+        if (list->arena_capacity > target - 1) return false;
+    }
+    return list->capacity == target;
+}
+
+// Swaps two random slots, one of which may be free; the live payloads must
+// follow their slots and the logical order must stay put
+template <typename List>
+static bool swap_checked(List* list, uint64_t* seed) {
+    ssize_t first_idx  = (ssize_t)(rand_next(seed) % (list->untouched - 1)) + 1;
+    ssize_t second_idx = (ssize_t)(rand_next(seed) % (list->untouched - 1)) + 1;
+    bool first_free    = list_node_is_free(list, first_idx);
+    bool second_free   = list_node_is_free(list, second_idx);
+    long first_key     = first_free  ? -1 : get_key(tlist_val(list, first_idx));
+    long second_key    = second_free ? -1 : get_key(tlist_val(list, second_idx));
+
+    if (list_swap(list, first_idx, second_idx) != ERROR_NO) {
+        return false;
+    }
+    if (first_idx == second_idx || (first_free && second_free)) {
+        return true;
+    }
+    return list_node_is_free(list, first_idx)  == second_free &&
+           list_node_is_free(list, second_idx) == first_free  &&
+           (second_free || get_key(tlist_val(list, first_idx))  == second_key) &&
+           (first_free  || get_key(tlist_val(list, second_idx)) == first_key);
+}
+
+template <typename List>
+static error_code test_tlist(const char* name) {
+    typedef typename List::value_type value_type;
+
+    List list = {};
+    if (list_init(&list, 0) != ERROR_NO) {
+        printf("FAIL %s: init\n", name);
+        return ERROR_MEM_ALLOC;
+    }
+    std::vector<long> expected;
+    uint64_t seed     = 0x9E3779B97F4A7C15ull;
+    long     next_key = 0;
+    const char* failed = nullptr;
+
+    for (int op = 1; op <= TEST_OPS && failed == nullptr; ++op) {
+        const size_t count = expected.size();
+        const uint64_t dice = rand_next(&seed) % 8;
+        value_type val = {};
+        set_key(&val, next_key);
+
+        if (count == 0 || (dice < 4 && count < TEST_MAX_ELEMS)) {
+            if (count == 0 || dice == 0) {
+                list_push_back(&list, std::move(val));
+                expected.push_back(next_key);
+            } else if (dice == 1) {
+                list_push_front(&list, std::move(val));
+                expected.insert(expected.begin(), next_key);
+            } else {
+                ssize_t pos = (ssize_t)(rand_next(&seed) % count);
+                list_insert_auto(&list, pos, std::move(val));
+                expected.insert(expected.begin() + pos + 1, next_key);
+            }
+            next_key++;
+        } else if (dice == 4) {
+            list_pop_front(&list);
+            expected.erase(expected.begin());
+        } else {
+            // mostly from the middle, which leaves holes in the arena
+            ssize_t pos = (ssize_t)(rand_next(&seed) % count);
+            if (list_remove_auto(&list, pos) != ERROR_NO) failed = "remove_auto";
+            expected.erase(expected.begin() + pos);
+        }
+        if (failed == nullptr && !same_as(&list, expected)) failed = "insert / remove";
+
+        if (failed == nullptr && op % TEST_SWAP_EVERY == 0 && list.untouched > 1 &&
+            (!swap_checked(&list, &seed) || !same_as(&list, expected))) {
+            failed = "swap";
+        }
+        if (failed == nullptr && op % TEST_LINEAR_EVERY == 0 &&
+            (list_linearize(&list) != ERROR_NO || !is_linear(&list) || !same_as(&list, expected))) {
+            failed = "linearize";
+        }
+        if (failed == nullptr && op % TEST_SHRINK_EVERY == 0 &&
+            (list_shrink_to_fit(&list, false) != ERROR_NO || !is_linear(&list) || !is_trimmed(&list) ||
+             !same_as(&list, expected))) {
+            failed = "shrink_to_fit";
+        }
+    }
+    while (failed == nullptr && !expected.empty()) {
+        list_pop_back(&list);
+        expected.pop_back();
+        if (!same_as(&list, expected)) failed = "pop_back";
+    }
+    list_dest(&list);
+
+    if (failed != nullptr) {
+        printf("FAIL %s: %s\n", name, failed);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    printf("ok   %s\n", name);
+    return ERROR_NO;
+}
+
+//==============================================================================
+// list_t: keys are non-negative integers stored as node values, so they never
+// meet POISON and compare exactly once converted back
+
+static const int    LIST_OPS       = 3000;
+static const size_t LIST_MAX_ELEMS = 200;
+
+static bool list_same_as(list_t* list, const std::vector<long>& expected) {
+    if (list_verify(list, VER_INIT, DUMP_NO, "list_test") != ERROR_NO || list->size - 1 != expected.size()) {
+        return false;
+    }
+    ssize_t cur = list->head;
+    for (long key : expected) {
+        if (cur == 0 || (long)node_val(list, cur) != key) {
+            return false;
+        }
+        cur = node_next(list, cur);
+    }
+    return cur == 0;
+}
+
+// One random insert or remove through the list_t entry points, mirrored in
+// expected. Returns the slot an insert says it used (checked to hold the
+// key), 0 after a remove, -1 if the call failed.
+static ssize_t random_list_op(list_t* list, std::vector<long>* expected, uint64_t* seed, long* next_key) {
+    const size_t   count = expected->size();
+    const uint64_t dice  = rand_next(seed) % 8;
+    const ssize_t  pos   = count > 0 ? (ssize_t)(rand_next(seed) % count) : 0;
+
+    if (count == 0 || (dice < 4 && count < LIST_MAX_ELEMS)) {
+        const long key = (*next_key)++;
+        ssize_t idx = -1;
+        if (count == 0 || dice == 0) {
+            idx = list_push_back(list, (double)key);
+            expected->push_back(key);
+        } else if (dice == 1) {
+            idx = list_push_front(list, (double)key);
+            expected->insert(expected->begin(), key);
+        } else if (dice == 2) {
+            idx = list_insert_after(list, list_resolve_auto(list, pos), (double)key);
+            expected->insert(expected->begin() + pos + 1, key);
+        } else {
+            idx = list_insert_auto(list, pos, (double)key);
+            expected->insert(expected->begin() + pos + 1, key);
+        }
+        return idx > 0 && (long)node_val(list, idx) == key ? idx : -1;
+    }
+
+    error_code error = ERROR_NO;
+    if (dice == 4) {
+        error = list_pop_front(list);
+        expected->erase(expected->begin());
+    } else if (dice == 5) {
+        error = list_pop_back(list);
+        expected->pop_back();
+    } else if (dice == 6) {
+        error = list_remove(list, list_resolve_auto(list, pos));
+        expected->erase(expected->begin() + pos);
+    } else {
+        error = list_remove_auto(list, pos);
+        expected->erase(expected->begin() + pos);
+    }
+    return error == ERROR_NO ? 0 : -1;
+}
+
+static error_code test_result(const char* name, const char* failed, int op) {
+    if (failed != nullptr) {
+        printf("FAIL %s: %s (step %d)\n", name, failed, op);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    printf("ok   %s\n", name);
+    return ERROR_NO;
+}
+
+// Order index: list_logical_index and positional lookups agree with the
+// reference through inserts, removes, swaps, splices and relayouts
+static error_code test_order_index() {
+    list_t list = {};
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO || list_order_index_enable(&list) != ERROR_NO) {
+        return test_result("list_t order index", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed     = 0x0DDBA11ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        if (random_list_op(&list, &expected, &seed, &next_key) == -1) failed = "insert / remove";
+        const size_t count = expected.size();
+
+        if (failed == nullptr && count >= 2 && op % 5 == 0) {
+            // move a run of up to 8 nodes after a node outside it
+            size_t first = rand_next(&seed) % count;
+            size_t last  = first + rand_next(&seed) % 8;
+            if (last >= count) last = count - 1;
+            size_t after = rand_next(&seed) % (count + 1 - (last - first + 1));  // 0: front
+            if (after > first) after += last - first + 1;
+            ssize_t after_idx = after == 0 ? 0 : list_resolve_auto(&list, (ssize_t)after - 1);
+            if (list_splice(&list, after_idx, &list, list_resolve_auto(&list, (ssize_t)first),
+                            list_resolve_auto(&list, (ssize_t)last)) == -1) {
+                failed = "splice";
+            }
+            std::vector<long> run(expected.begin() + (ssize_t)first, expected.begin() + (ssize_t)last + 1);
+            expected.erase(expected.begin() + (ssize_t)first, expected.begin() + (ssize_t)last + 1);
+            size_t insert_at = after <= first ? after : after - run.size();
+            expected.insert(expected.begin() + (ssize_t)insert_at, run.begin(), run.end());
+        }
+        if (failed == nullptr && count >= 2 && op % 7 == 0 &&
+            list_swap(&list, list_resolve_auto(&list, (ssize_t)(rand_next(&seed) % count)),
+                             list_resolve_auto(&list, (ssize_t)(rand_next(&seed) % count))) != ERROR_NO) {
+            failed = "swap";
+        }
+        if (failed == nullptr && op % 401 == 0 && list_linearize(&list) != ERROR_NO) failed = "linearize";
+        if (failed == nullptr && op % 613 == 0 && list_linearize_copy(&list, nullptr) != ERROR_NO) {
+            failed = "linearize_copy";
+        }
+        if (failed == nullptr && !list_same_as(&list, expected)) failed = "sequence";
+
+        for (size_t probe = 0; failed == nullptr && probe < 4 && !expected.empty(); ++probe) {
+            ssize_t logical  = (ssize_t)(rand_next(&seed) % expected.size());
+            ssize_t physical = list_resolve_auto(&list, logical);
+            if (physical <= 0 || (long)node_val(&list, physical) != expected[(size_t)logical] ||
+                list_logical_index(&list, physical) != logical) {
+                failed = "logical index";
+            }
+        }
+    }
+    list_dest(&list);
+    return test_result("list_t order index", failed, op - 1);
+}
+
+static const int POOL_LISTS = 3;
+
+// Node pool: several lists share one store. Runs move between them with
+// list_splice, nodes move within one with list_move_after, and a sibling's
+// node is refused; the pool gets every slot back when the lists go.
+static error_code test_pool() {
+    list_node_pool_t pool = {};
+    list_t lists[POOL_LISTS] = {};
+    bool ok = list_node_pool_init(&pool, 0, LIST_STORAGE_FLAT, nullptr ON_DEBUG(, VER_INIT)) == ERROR_NO;
+    const size_t pool_size = pool.store.size;
+    for (int i = 0; ok && i < POOL_LISTS; ++i) {
+        ok = list_init_in_pool(&lists[i], &pool ON_DEBUG(, VER_INIT)) == ERROR_NO;
+    }
+    if (!ok) {
+        return test_result("list_t node pool", "init", 0);
+    }
+    std::vector<long> expected[POOL_LISTS];
+    uint64_t    seed     = 0xB16B00B5ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        const int which = (int)(rand_next(&seed) % POOL_LISTS);
+        const int other = (which + 1 + (int)(rand_next(&seed) % (POOL_LISTS - 1))) % POOL_LISTS;
+        list_t* list = &lists[which];
+        std::vector<long>& keys = expected[which];
+        if (random_list_op(list, &keys, &seed, &next_key) == -1) failed = "insert / remove";
+
+        if (failed == nullptr && op % 5 == 0 && !keys.empty() && expected[other].size() < LIST_MAX_ELEMS) {
+            // the tail end of `which` goes after a random node of `other`
+            size_t first = rand_next(&seed) % keys.size();
+            size_t after = rand_next(&seed) % (expected[other].size() + 1);  // 0: front
+            ssize_t after_idx = after == 0 ? 0 : list_resolve_auto(&lists[other], (ssize_t)after - 1);
+            if (list_splice(&lists[other], after_idx, list, list_resolve_auto(list, (ssize_t)first), list->tail) == -1) {
+                failed = "splice between lists";
+            }
+            expected[other].insert(expected[other].begin() + (ssize_t)after, keys.begin() + (ssize_t)first, keys.end());
+            keys.erase(keys.begin() + (ssize_t)first, keys.end());
+        }
+        if (failed == nullptr && op % 3 == 0 && keys.size() >= 2) {
+            size_t node = rand_next(&seed) % keys.size();
+            size_t dest = rand_next(&seed) % keys.size();
+            if (list_move_after(list, list_resolve_auto(list, (ssize_t)node),
+                                list_resolve_auto(list, (ssize_t)dest)) != ERROR_NO) {
+                failed = "move_after";
+            }
+            if (node != dest) {
+                long key = keys[node];
+                keys.erase(keys.begin() + (ssize_t)node);
+                keys.insert(keys.begin() + (ssize_t)(dest < node ? dest + 1 : dest), key);
+            }
+        }
+        if (failed == nullptr && op % 11 == 0 && !expected[other].empty() && !keys.empty()) {
+            ssize_t sibling = list_resolve_auto(&lists[other], 0);
+            if (list_move_after(list, sibling, list->head) == ERROR_NO ||
+                list_move_after(list, list->head, sibling) == ERROR_NO ||
+                list_splice(list, 0, list, sibling, sibling) != -1) {
+                failed = "sibling node accepted";
+            }
+        }
+        for (int i = 0; failed == nullptr && i < POOL_LISTS; ++i) {
+            if (!list_same_as(&lists[i], expected[i])) failed = "sequence";
+        }
+    }
+    for (int i = 0; i < POOL_LISTS; ++i) {
+        list_dest(&lists[i]);
+    }
+    if (failed == nullptr && (pool.store.size != pool_size ||
+                              list_verify(&pool.store, VER_INIT, DUMP_NO, "pool after dest") != ERROR_NO)) {
+        failed = "slots not returned to the pool";
+    }
+    list_node_pool_dest(&pool);
+    return test_result("list_t node pool", failed, op - 1);
+}
+
+static const int SHRINK_PHASE = 400;
+
+// Shrink policy: phases of growth and of removes. After every remove the
+// storage is back under size * reduction_factor unless it is at the floor
+// the policy allows, and it did shrink along the way.
+static error_code test_shrink_policy() {
+    list_t list = {};
+    const list_shrink_policy_t policy = LIST_SHRINK_DEFAULT;
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO || list_set_shrink_policy(&list, &policy) != ERROR_NO) {
+        return test_result("list_t shrink policy", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed     = 0x5B1A7Cull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    size_t      shrinks  = 0;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        const size_t capacity = list.capacity;
+        if ((op / SHRINK_PHASE) % 2 == 0 || expected.empty()) {
+            if (random_list_op(&list, &expected, &seed, &next_key) == -1) failed = "insert / remove";
+        } else {
+            ssize_t pos = (ssize_t)(rand_next(&seed) % expected.size());
+            if (list_remove_auto(&list, pos) != ERROR_NO) failed = "remove_auto";
+            expected.erase(expected.begin() + pos);
+
+            size_t floor = (size_t)((double)list.size * (double)policy.headroom);
+            if (floor < list.size + 2)         floor = list.size + 2;
+            if (floor < policy.min_capacity)   floor = policy.min_capacity;
+            if ((double)list.size * (double)policy.reduction_factor < (double)list.capacity && list.capacity > floor) {
+                failed = "did not shrink";
+            }
+        }
+        shrinks += list.capacity < capacity;
+        if (failed == nullptr && !list_same_as(&list, expected)) failed = "sequence";
+    }
+    if (failed == nullptr && shrinks == 0) failed = "never shrank";
+    list_dest(&list);
+    return test_result("list_t shrink policy", failed, op - 1);
+}
+
+static const size_t COMPACT_BUDGET = 3;
+static const int    COMPACT_PHASE  = 300;
+
+// Compaction budget: random phases with the budget on (inserts must still
+// return the slot their node ends up in), explicit list_compact_step calls,
+// and push_back phases, which only extend the list, so the budget must catch
+// up and leave it linear.
+static error_code test_compact_budget() {
+    list_t list = {};
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO) {
+        return test_result("list_t compact budget", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed     = 0xC0117AC7ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        const int phase = (op / COMPACT_PHASE) % 3;
+        if (op % COMPACT_PHASE == 0) {
+            list_set_compact_budget(&list, phase == 0 ? 0 : COMPACT_BUDGET);
+        }
+        if (phase != 2) {
+            if (random_list_op(&list, &expected, &seed, &next_key) == -1) failed = "insert / remove";
+        } else {
+            ssize_t idx = list_push_back(&list, (double)next_key);
+            if (idx <= 0 || (long)node_val(&list, idx) != next_key) failed = "push_back";
+            expected.push_back(next_key++);
+            // each push_back settles COMPACT_BUDGET nodes and adds one
+            int pushed = op % COMPACT_PHASE + 1;
+            if (failed == nullptr && (size_t)pushed * (COMPACT_BUDGET - 1) >= expected.size() &&
+                !list_is_linear(&list)) {
+                failed = "not linear after the push_back phase";
+            }
+        }
+        if (failed == nullptr && phase == 0 && op % 13 == 0) {
+            size_t want = list.linear_prefix + 2 * COMPACT_BUDGET;
+            if (want > list.size - 1) want = list.size - 1;
+            if (list_compact_step(&list, 2 * COMPACT_BUDGET) != ERROR_NO || list.linear_prefix < want) {
+                failed = "compact_step";
+            }
+        }
+        if (failed == nullptr && !list_same_as(&list, expected)) failed = "sequence";
+        if (phase == 2 && expected.size() > 2 * LIST_MAX_ELEMS) {
+            expected.erase(expected.begin() + (ssize_t)LIST_MAX_ELEMS, expected.end());
+            while (list.size - 1 > LIST_MAX_ELEMS) list_pop_back(&list);
+        }
+    }
+    list_dest(&list);
+    return test_result("list_t compact budget", failed, op - 1);
+}
+
+// Relayout policy: after every insert or remove the list is either local
+// enough, too small, too few mutations past its last relayout, or was just
+// relaid out (mutations back to 0). Inserts must return the node's new slot.
+static error_code test_relayout_policy() {
+    list_t list = {};
+    const list_relayout_policy_t policy = {0.5f, 1.0f, 16};
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO || list_set_relayout_policy(&list, &policy) != ERROR_NO) {
+        return test_result("list_t relayout policy", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed      = 0x4E1A7011ull;
+    long        next_key  = 0;
+    const char* failed    = nullptr;
+    size_t      relayouts = 0;
+    int         op        = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        if (random_list_op(&list, &expected, &seed, &next_key) == -1) failed = "insert / remove";
+        const double count = (double)(list.size - 1);
+        if (list.mutations == 0) {
+            relayouts++;
+            if (list_locality(&list) < 1.0) failed = "relayout left the list scattered";
+        } else if (list_locality(&list) < (double)policy.min_locality && count >= (double)policy.min_size &&
+                   (double)list.mutations >= (double)policy.amortize * count) {
+            failed = "policy should have fired";
+        }
+        if (failed == nullptr && !list_same_as(&list, expected)) failed = "sequence";
+    }
+    if (failed == nullptr && relayouts == 0) failed = "never relaid out";
+    list_dest(&list);
+    return test_result("list_t relayout policy", failed, op - 1);
+}
+
+static const int HANDLE_MOVE_EVERY  = 5;
+static const int HANDLE_REMAP_EVERY = 97;
+
+// Every handle taken so far (indexed by key) resolves to its node while the
+// key is in expected, and to -1 once it was removed.
+static bool handles_match(const list_t* list, const std::vector<list_handle_t>& handles,
+                          const std::vector<long>& expected) {
+    std::vector<bool> live(handles.size(), false);
+    for (long key : expected) live[(size_t)key] = true;
+
+    for (size_t key = 0; key < handles.size(); ++key) {
+        ssize_t slot = list_handle_resolve(list, handles[key]);
+        if (live[key] ? slot <= 0 || (long)node_val(list, slot) != (long)key : slot != -1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Moves nodes around without changing the sequence
+static error_code shuffle_slots(list_t* list, const std::vector<long>& expected, uint64_t* seed) {
+    switch (rand_next(seed) % 5) {
+        case 0:
+            return list_linearize(list);
+        case 1:
+            return list_linearize_copy(list, nullptr);
+        case 2:
+            return list_shrink_to_fit(list, rand_next(seed) % 2 == 0);
+        case 3:
+            return list_compact_step(list, 4);
+        default:
+            if (expected.size() < 2) return ERROR_NO;
+            return list_swap(list, list_resolve_auto(list, (ssize_t)(rand_next(seed) % expected.size())),
+                                   list_resolve_auto(list, (ssize_t)(rand_next(seed) % expected.size())));
+    }
+}
+
+// Handles and the remap: a handle follows its node through swaps, both
+// linearizes, shrinking and compaction, and goes stale once the node is
+// removed. Every HANDLE_REMAP_EVERY steps the slots are recorded and a
+// list_remap_begin / list_remap_end pair has to map each one to its node's
+// new slot, or -1 if it was free or its node is gone.
+static error_code test_handles() {
+    list_t list = {};
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO || list_handles_enable(&list) != ERROR_NO) {
+        return test_result("list_t handles", "init", 0);
+    }
+    std::vector<long>          expected;
+    std::vector<list_handle_t> handles;
+    std::vector<long>          key_at;   // slot -> key at list_remap_begin, -1 if free
+    uint64_t    seed     = 0x4A4D7E5ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        if (op % HANDLE_REMAP_EVERY == 1) {
+            key_at.assign(list.capacity, -1);
+            for (ssize_t cur = list.head; cur != 0; cur = node_next(&list, cur)) {
+                key_at[(size_t)cur] = (long)node_val(&list, cur);
+            }
+            if (list_remap_begin(&list) != ERROR_NO) failed = "remap_begin";
+        }
+
+        ssize_t idx = random_list_op(&list, &expected, &seed, &next_key);
+        if (idx == -1) {
+            failed = "insert / remove";
+        } else if (idx > 0) {
+            list_handle_t handle = list_handle_of(&list, idx);
+            if (handle.id < 0) failed = "handle_of";
+            handles.push_back(handle);
+        }
+        if (failed == nullptr && op % HANDLE_MOVE_EVERY == 0 && shuffle_slots(&list, expected, &seed) != ERROR_NO) {
+            failed = "moving nodes";
+        }
+        if (failed == nullptr && !list_same_as(&list, expected))              failed = "sequence";
+        if (failed == nullptr && !handles_match(&list, handles, expected))    failed = "handle_resolve";
+
+        if (failed == nullptr && op % HANDLE_REMAP_EVERY == 0) {
+            std::vector<list_index_t> remap(key_at.size(), 0);
+            if (list_remap_end(&list, remap.data()) != ERROR_NO) failed = "remap_end";
+            std::vector<bool> live((size_t)next_key, false);
+            for (long key : expected) live[(size_t)key] = true;
+
+            for (size_t old = 1; old < key_at.size() && failed == nullptr; ++old) {
+                const long key = key_at[old];
+                if (key >= 0 && live[(size_t)key]) {
+                    if (remap[old] <= 0 || (long)node_val(&list, remap[old]) != key) failed = "remap of a live node";
+                } else if (remap[old] != -1) {
+                    failed = "remap of a free or removed slot";
+                }
+            }
+        }
+    }
+    list_dest(&list);
+    return test_result("list_t handles", failed, op - 1);
+}
+
+static const int VALUE_REMOVE_EVERY = 3;
+
+// Value index: list_find / list_contains see every live key at its slot and
+// none of the removed ones, through random inserts and removes, list_remove_value
+// and the same node moves as the handle test.
+static error_code test_value_index() {
+    list_t list = {};
+    if (list_init(&list, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO || list_value_index_enable(&list) != ERROR_NO) {
+        return test_result("list_t value index", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed     = 0xF1DF1Dull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        if (random_list_op(&list, &expected, &seed, &next_key) == -1) failed = "insert / remove";
+        if (failed == nullptr && op % VALUE_REMOVE_EVERY == 0 && !expected.empty()) {
+            size_t pos = rand_next(&seed) % expected.size();
+            if (list_remove_value(&list, (double)expected[pos]) != ERROR_NO) failed = "remove_value";
+            expected.erase(expected.begin() + (ssize_t)pos);
+        }
+        if (failed == nullptr && op % HANDLE_MOVE_EVERY == 0 && shuffle_slots(&list, expected, &seed) != ERROR_NO) {
+            failed = "moving nodes";
+        }
+        if (failed == nullptr && list_remove_value(&list, (double)next_key) != ERROR_MISSED_ELEM) {
+            failed = "remove_value of a missing key";
+        }
+        if (failed == nullptr && !list_same_as(&list, expected)) failed = "sequence";
+
+        std::vector<bool> live((size_t)next_key, false);
+        for (long key : expected) live[(size_t)key] = true;
+        for (long key = 0; key < next_key && failed == nullptr; ++key) {
+            ssize_t slot = list_find(&list, (double)key);
+            if (live[(size_t)key] ? slot <= 0 || (long)node_val(&list, slot) != key : slot != -1) {
+                failed = "find";
+            } else if (list_contains(&list, (double)key) != live[(size_t)key]) {
+                failed = "contains";
+            }
+        }
+    }
+    list_dest(&list);
+    return test_result("list_t value index", failed, op - 1);
+}
+
+static const size_t LRU_ENTRIES = 64;
+static const size_t LRU_KEYS    = LRU_ENTRIES * 5 / 4;
+
+// LRU cache against a recency vector (most recent first) and a key -> value
+// array: random gets and puts over a key space a quarter bigger than the
+// cache, comparing hits, values, evictions and the list order.
+static error_code test_lru() {
+    list_lru_t lru = {};
+    if (list_lru_init(&lru, LRU_ENTRIES ON_DEBUG(, VER_INIT)) != ERROR_NO) {
+        return test_result("list_t LRU", "init", 0);
+    }
+    std::vector<long> recency;
+    std::vector<long> value_of(LRU_KEYS, -1);
+    uint64_t    seed      = 0x1C4C4Eull;
+    const char* failed    = nullptr;
+    size_t      evictions = 0;
+    int         op        = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        const long key = (long)(rand_next(&seed) % LRU_KEYS);
+        std::vector<long>::iterator it = std::find(recency.begin(), recency.end(), key);
+        const bool cached = it != recency.end();
+        if (cached) recency.erase(it);
+
+        if (rand_next(&seed) % 2 == 0) {
+            double value = 0;
+            const bool hit = list_lru_get(&lru, (double)key, &value);
+            if (hit != cached || (hit && (long)value != value_of[(size_t)key])) failed = "get";
+            if (cached) recency.insert(recency.begin(), key);
+        } else {
+            bool evicted = false;
+            if (list_lru_put(&lru, (double)key, (double)op, &evicted) != ERROR_NO) failed = "put";
+            const bool full = !cached && recency.size() == LRU_ENTRIES;
+            if (evicted != full) failed = "eviction";
+            if (full) {
+                recency.pop_back();
+                evictions++;
+            }
+            recency.insert(recency.begin(), key);
+            value_of[(size_t)key] = op;
+        }
+        if (failed == nullptr && list_lru_size(&lru) != recency.size()) failed = "size";
+        if (failed == nullptr && !list_same_as(&lru.list, recency))   failed = "recency order";
+    }
+    if (failed == nullptr && evictions == 0) failed = "never evicted";
+    list_lru_dest(&lru);
+    return test_result("list_t LRU", failed, op - 1);
+}
+
+static const int UNROLLED_PHASE      = 500;
+static const int UNROLLED_PACK_EVERY = 211;
+
+static bool unrolled_same_as(const list_unrolled_t* list, const std::vector<long>& expected) {
+    if (list_unrolled_verify(list) != ERROR_NO || list_unrolled_size(list) != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        double val = 0;
+        if (list_unrolled_get(list, i, &val) != ERROR_NO || (long)val != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Unrolled list: random positional inserts, removes and sets plus pushes and
+// pops at both ends, against a vector. Phases that favour inserts fill and
+// split blocks, the ones favouring removes merge them; every
+// UNROLLED_PACK_EVERY steps the blocks are packed by linearize or
+// shrink_to_fit. list_unrolled_verify checks the block counts and links
+// after each step.
+static error_code test_unrolled() {
+    list_unrolled_t list = {};
+    if (list_unrolled_init(&list, 0) != ERROR_NO) {
+        return test_result("unrolled list", "init", 0);
+    }
+    std::vector<long> expected;
+    uint64_t    seed     = 0xB10C5ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    for (; op <= LIST_OPS && failed == nullptr; ++op) {
+        const size_t   count = expected.size();
+        const uint64_t dice  = rand_next(&seed) % 8;
+        const size_t   pos   = count > 0 ? (size_t)(rand_next(&seed) % count) : 0;
+        const bool     grow  = (op / UNROLLED_PHASE) % 2 == 0;
+        error_code     error = ERROR_NO;
+
+        if (count == 0 || ((grow ? dice < 6 : dice < 2) && count < LIST_MAX_ELEMS)) {
+            const long key = next_key++;
+            if (count == 0 || dice % 3 == 0) {
+                const size_t at = (size_t)(rand_next(&seed) % (count + 1));
+                error = list_unrolled_insert_at(&list, at, (double)key);
+                expected.insert(expected.begin() + (ssize_t)at, key);
+            } else if (dice % 3 == 1) {
+                error = list_unrolled_push_front(&list, (double)key);
+                expected.insert(expected.begin(), key);
+            } else {
+                error = list_unrolled_push_back(&list, (double)key);
+                expected.push_back(key);
+            }
+        } else if (dice == 2 || dice == 3) {
+            error = list_unrolled_set(&list, pos, (double)next_key);
+            expected[pos] = next_key++;
+        } else if (dice == 4) {
+            error = list_unrolled_pop_front(&list);
+            expected.erase(expected.begin());
+        } else if (dice == 5) {
+            error = list_unrolled_pop_back(&list);
+            expected.pop_back();
+        } else {
+            error = list_unrolled_remove_at(&list, pos);
+            expected.erase(expected.begin() + (ssize_t)pos);
+        }
+        if (error != ERROR_NO) failed = "insert / remove / set";
+
+        if (failed == nullptr && op % UNROLLED_PACK_EVERY == 0) {
+            error = op % 2 == 0 ? list_unrolled_linearize(&list)
+                                : list_unrolled_shrink_to_fit(&list, rand_next(&seed) % 2 == 0);
+            if (error != ERROR_NO) failed = "linearize / shrink_to_fit";
+        }
+        if (failed == nullptr && !unrolled_same_as(&list, expected)) failed = "sequence";
+    }
+    double past_end = 0;
+    if (failed == nullptr && list_unrolled_get(&list, expected.size(), &past_end) != ERROR_INCORRECT_INDEX) {
+        failed = "get past the end";
+    }
+    list_unrolled_dest(&list);
+    return test_result("unrolled list", failed, op - 1);
+}
+
+static const int REDUCE_OPS          = 1000;
+static const int REDUCE_LINEAR_EVERY = 97;
+
+// Sum, min, max and a range count against the keys; they are whole numbers,
+// so the sum is exact in any order
+static bool reductions_match(const list_t* list, const std::vector<long>& expected, long lo, long hi) {
+    long   sum   = 0;
+    long   min   = 0;
+    long   max   = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        sum += expected[i];
+        if (i == 0 || expected[i] < min) min = expected[i];
+        if (i == 0 || expected[i] > max) max = expected[i];
+        count += lo <= expected[i] && expected[i] <= hi;
+    }
+    double min_val = 0;
+    double max_val = 0;
+    const error_code want = expected.empty() ? ERROR_MISSED_ELEM : ERROR_NO;
+    if (list_min(list, &min_val) != want || list_max(list, &max_val) != want) {
+        return false;
+    }
+    return (long)list_reduce_sum(list) == sum && list_count_if_range(list, (double)lo, (double)hi) == count &&
+           (expected.empty() || ((long)min_val == min && (long)max_val == max));
+}
+
+// Reductions at one SIMD level: a flat list scattered by random inserts and
+// removes (free slots included), linearized now and then for the contiguous
+// path, and two lists sharing a node pool.
+static error_code test_reduce_at(list_simd_level_t level, const char* name) {
+    list_t flat = {};
+    list_node_pool_t pool = {};
+    list_t shared[2] = {};
+    if (list_init(&flat, 0 ON_DEBUG(, VER_INIT)) != ERROR_NO ||
+        list_node_pool_init(&pool, 0, LIST_STORAGE_FLAT, nullptr ON_DEBUG(, VER_INIT)) != ERROR_NO ||
+        list_init_in_pool(&shared[0], &pool ON_DEBUG(, VER_INIT)) != ERROR_NO ||
+        list_init_in_pool(&shared[1], &pool ON_DEBUG(, VER_INIT)) != ERROR_NO) {
+        return test_result(name, "init", 0);
+    }
+    list_simd_force(level);
+    std::vector<long> expected[3];
+    list_t*     lists[3] = {&flat, &shared[0], &shared[1]};
+    uint64_t    seed     = 0x5EDCE5ull;
+    long        next_key = 0;
+    const char* failed   = nullptr;
+    int         op       = 1;
+
+    if (!reductions_match(&flat, expected[0], 0, 0)) failed = "empty list";
+    for (; op <= REDUCE_OPS && failed == nullptr; ++op) {
+        const int which = (int)(rand_next(&seed) % 3);
+        if (random_list_op(lists[which], &expected[which], &seed, &next_key) == -1) failed = "insert / remove";
+        if (failed == nullptr && op % REDUCE_LINEAR_EVERY == 0 && list_linearize(&flat) != ERROR_NO) {
+            failed = "linearize";
+        }
+        const long lo = next_key > 0 ? (long)(rand_next(&seed) % (uint64_t)next_key) : 0;
+        const long hi = lo + (long)(rand_next(&seed) % (LIST_MAX_ELEMS + 1));
+        for (int i = 0; i < 3 && failed == nullptr; ++i) {
+            if (!list_same_as(lists[i], expected[i]))                  failed = "sequence";
+            else if (!reductions_match(lists[i], expected[i], lo, hi)) failed = "reduction";
+        }
+    }
+    list_simd_force(LIST_SIMD_AVX2);
+    list_dest(&shared[1]);
+    list_dest(&shared[0]);
+    list_node_pool_dest(&pool);
+    list_dest(&flat);
+    return test_result(name, failed, op - 1);
+}
+
+// Every level the CPU has; list_simd_force lowers the rest
+static error_code test_reduce() {
+    error_code error = test_reduce_at(LIST_SIMD_SCALAR, "list_t reductions, scalar");
+    if (list_simd_force(LIST_SIMD_SSE2) == LIST_SIMD_SSE2) {
+        error |= test_reduce_at(LIST_SIMD_SSE2, "list_t reductions, SSE2");
+    }
+    if (list_simd_force(LIST_SIMD_AVX2) == LIST_SIMD_AVX2) {
+        error |= test_reduce_at(LIST_SIMD_AVX2, "list_t reductions, AVX2");
+    }
+    return error;
+}
+
+//==============================================================================
+
+int main() {
+    logger_initialize_stream(nullptr);
+    error_code error = ERROR_NO;
+
+    error |= test_tlist<tlist_t<double>>("tlist_t<double>");
+    error |= test_tlist<tlist_t<double, int32_t, list_debug_verify>>("tlist_t<double, int32_t, verify>");
+    error |= test_tlist<tlist_t<std::string, list_index_t, list_debug_off>>("tlist_t<std::string>");
+    error |= test_tlist<tlist_t<std::string, int32_t, list_debug_verify>>("tlist_t<std::string, int32_t, verify>");
+    error |= test_tlist<tlist_t<test_payload_t, int32_t, list_debug_verify>>("tlist_t<256-byte payload, int32_t, verify>");
+
+    error |= test_tlist<tlist_t<double, list_index_t, list_debug_off, list_payload_arena>>("arena tlist_t<double>");
+    error |= test_tlist<tlist_t<test_payload_t, int32_t, list_debug_verify, list_payload_arena>>(
+        "arena tlist_t<256-byte payload, int32_t, verify>");
+    error |= test_tlist<tlist_t<std::string, list_index_t, list_debug_verify, list_payload_arena>>(
+        "arena tlist_t<std::string, verify>");
+
+    error |= test_order_index();
+    error |= test_pool();
+    error |= test_shrink_policy();
+    error |= test_compact_budget();
+    error |= test_relayout_policy();
+    error |= test_handles();
+    error |= test_value_index();
+    error |= test_lru();
+    error |= test_unrolled();
+    error |= test_reduce();
+
+    return error == ERROR_NO ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+#include "list_unrolled.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//==============================================================================
+
+static inline unrolled_block_t& block(const list_unrolled_t* list, ssize_t idx);
+static inline error_code checked(const list_unrolled_t* list);
+static error_code resize_blocks(list_unrolled_t* list, size_t capacity);
+static ssize_t    take_block(list_unrolled_t* list);
+static void       release_block(list_unrolled_t* list, ssize_t idx);
+static void       link_block_after(list_unrolled_t* list, ssize_t after_idx, ssize_t idx);
+static void       unlink_block(list_unrolled_t* list, ssize_t idx);
+static ssize_t    locate(const list_unrolled_t* list, size_t logical_index, size_t* offset_return);
+static ssize_t    make_room(list_unrolled_t* list, ssize_t idx, size_t* offset);
+static void       rebalance(list_unrolled_t* list, ssize_t idx);
+
+//==============================================================================
+
+static inline unrolled_block_t& block(const list_unrolled_t* list, ssize_t idx) {
+    return list->blocks[idx];
+}
+
+static inline error_code checked(const list_unrolled_t* list) {
+    error_code error = ERROR_NO;
+    ON_DEBUG(
+        error = list_unrolled_verify(list);
+    )
+    (void)list;
+    return error;
+}
+
+static error_code resize_blocks(list_unrolled_t* list, size_t capacity) {
+    unrolled_block_t* blocks = (unrolled_block_t*)realloc(list->blocks, capacity * sizeof(unrolled_block_t));
+    if (blocks == nullptr) {
+        LOGGER_ERROR("realloc failed for %lu unrolled blocks", capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    list->blocks   = blocks;
+    list->capacity = capacity;
+    return ERROR_NO;
+}
+
+// An empty, unlinked block; -1 if the block array cannot grow
+static ssize_t take_block(list_unrolled_t* list) {
+    ssize_t idx = list->free_head;
+    if (idx != -1) {
+        list->free_head = block(list, idx).next;
+    } else {
+        if (list->untouched == list->capacity) {
+            size_t capacity = (size_t)((double)list->capacity * (double)GROWTH_FACTOR);
+            if (capacity > LIST_MAX_CAPACITY) capacity = LIST_MAX_CAPACITY;
+            if (capacity <= list->capacity || resize_blocks(list, capacity) != ERROR_NO) {
+                return -1;
+            }
+        }
+        idx = (ssize_t)list->untouched++;
+    }
+    block(list, idx).count = 0;
+    list->used++;
+    return idx;
+}
+
+static void release_block(list_unrolled_t* list, ssize_t idx) {
+    unrolled_block_t& freed = block(list, idx);
+    freed.prev  = POISON;
+    freed.next  = as_index(list->free_head);
+    freed.count = 0;
+    list->free_head = idx;
+    list->used--;
+}
+
+static void link_block_after(list_unrolled_t* list, ssize_t after_idx, ssize_t idx) {
+    ssize_t next_idx = block(list, after_idx).next;
+    block(list, idx).prev       = as_index(after_idx);
+    block(list, idx).next       = as_index(next_idx);
+    block(list, after_idx).next = as_index(idx);
+    block(list, next_idx).prev  = as_index(idx);
+}
+
+static void unlink_block(list_unrolled_t* list, ssize_t idx) {
+    ssize_t prev_idx = block(list, idx).prev;
+    ssize_t next_idx = block(list, idx).next;
+    block(list, prev_idx).next = as_index(next_idx);
+    block(list, next_idx).prev = as_index(prev_idx);
+}
+
+// Block holding value logical_index (< size) and its offset there, walking
+// whole blocks from the nearer end
+static ssize_t locate(const list_unrolled_t* list, size_t logical_index, size_t* offset_return) {
+    ssize_t idx = 0;
+    if (logical_index < list->size / 2) {
+        idx = block(list, 0).next;
+        while (logical_index >= block(list, idx).count) {
+            logical_index -= block(list, idx).count;
+            idx = block(list, idx).next;
+        }
+        *offset_return = logical_index;
+    } else {
+        size_t from_back = list->size - logical_index;
+        idx = block(list, 0).prev;
+        while (from_back > block(list, idx).count) {
+            from_back -= block(list, idx).count;
+            idx = block(list, idx).prev;
+        }
+        *offset_return = block(list, idx).count - from_back;
+    }
+    return idx;
+}
+
+// idx is full and a value is going in at *offset. At either end of the block
+// the value goes to the neighbour if it has room, or to a fresh block, so
+// sequential fills leave full blocks behind; in the middle the block splits
+// in two. Returns the block to insert into (*offset adjusted), -1 if out of
+// memory.
+static ssize_t make_room(list_unrolled_t* list, ssize_t idx, size_t* offset) {
+    if (*offset == UNROLLED_BLOCK) {
+        ssize_t next_idx = block(list, idx).next;
+        if (next_idx != 0 && block(list, next_idx).count < UNROLLED_BLOCK) {
+            *offset = 0;
+            return next_idx;
+        }
+        ssize_t fresh = take_block(list);
+        if (fresh != -1) {
+            link_block_after(list, idx, fresh);
+            *offset = 0;
+        }
+        return fresh;
+    }
+    if (*offset == 0) {
+        ssize_t prev_idx = block(list, idx).prev;
+        if (prev_idx != 0 && block(list, prev_idx).count < UNROLLED_BLOCK) {
+            *offset = block(list, prev_idx).count;
+            return prev_idx;
+        }
+        ssize_t fresh = take_block(list);
+        if (fresh != -1) {
+            link_block_after(list, prev_idx, fresh);
+        }
+        return fresh;
+    }
+
+    ssize_t fresh = take_block(list);
+    if (fresh == -1) {
+        return -1;
+    }
+    const size_t half = UNROLLED_BLOCK / 2;
+    unrolled_block_t& full = block(list, idx);
+    unrolled_block_t& upper = block(list, fresh);
+    memcpy(upper.vals, full.vals + half, (UNROLLED_BLOCK - half) * sizeof(double));
+    upper.count = (uint32_t)(UNROLLED_BLOCK - half);
+    full.count  = (uint32_t)half;
+    link_block_after(list, idx, fresh);
+
+    if (*offset > half) {
+        *offset -= half;
+        return fresh;
+    }
+    return idx;
+}
+
+// idx dropped below UNROLLED_MERGE: fold it into a neighbour if the pair
+// leaves room for UNROLLED_MERGE more values, otherwise split the pair's
+// values evenly between the two
+static void rebalance(list_unrolled_t* list, ssize_t idx) {
+    ssize_t left  = block(list, idx).prev;
+    ssize_t right = idx;
+    if (left == 0) {
+        left  = idx;
+        right = block(list, idx).next;
+        if (right == 0) {
+            return;
+        }
+    }
+    unrolled_block_t& l = block(list, left);
+    unrolled_block_t& r = block(list, right);
+    const size_t total = (size_t)l.count + r.count;
+
+    if (total + UNROLLED_MERGE <= UNROLLED_BLOCK) {
+        memcpy(l.vals + l.count, r.vals, r.count * sizeof(double));
+        l.count = (uint32_t)total;
+        unlink_block(list, right);
+        release_block(list, right);
+        return;
+    }
+    const size_t target = total / 2;
+    if (l.count > target) {
+        size_t moved = l.count - target;
+        memmove(r.vals + moved, r.vals, r.count * sizeof(double));
+        memcpy(r.vals, l.vals + target, moved * sizeof(double));
+        r.count = (uint32_t)(r.count + moved);
+        l.count = (uint32_t)target;
+    } else {
+        size_t moved = target - l.count;
+        memcpy(l.vals + l.count, r.vals, moved * sizeof(double));
+        memmove(r.vals, r.vals + moved, (r.count - moved) * sizeof(double));
+        r.count = (uint32_t)(r.count - moved);
+        l.count = (uint32_t)target;
+    }
+}
+
+//==============================================================================
+
+error_code list_unrolled_init(list_unrolled_t* list, size_t capacity) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    LOGGER_DEBUG("Initialising unrolled list for %lu values", capacity);
+
+    size_t blocks = (capacity + UNROLLED_BLOCK - 1) / UNROLLED_BLOCK + 1;
+    if (blocks < MIN_LIST_SIZE) blocks = MIN_LIST_SIZE;
+    if (blocks > LIST_MAX_CAPACITY) {
+        LOGGER_ERROR("Requested capacity %lu exceeds index range", capacity);
+        return ERROR_BIG_SIZE;
+    }
+    *list = {};
+    error_code error = resize_blocks(list, blocks);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    block(list, 0).next  = 0;
+    block(list, 0).prev  = 0;
+    block(list, 0).count = 0;
+    list->untouched = 1;
+    list->used      = 1;
+    list->free_head = -1;
+    return checked(list);
+}
+
+error_code list_unrolled_dest(list_unrolled_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    LOGGER_DEBUG("Destroying unrolled list");
+
+    free(list->blocks);
+    *list = {};
+    return ERROR_NO;
+}
+
+error_code list_unrolled_insert_at(list_unrolled_t* list, size_t logical_index, double val) {
+    HARD_ASSERT(list != nullptr,         "list is nullptr");
+    HARD_ASSERT(list->blocks != nullptr, "blocks is nullptr");
+
+    if (logical_index > list->size) {
+        LOGGER_ERROR("list_unrolled_insert_at: index %lu out of range (size %lu)", logical_index, list->size);
+        return ERROR_INCORRECT_INDEX;
+    }
+    ssize_t idx    = 0;
+    size_t  offset = 0;
+    if (list->size == 0) {
+        idx = take_block(list);
+        if (idx != -1) {
+            link_block_after(list, 0, idx);
+        }
+    } else if (logical_index == list->size) {
+        idx    = block(list, 0).prev;
+        offset = block(list, idx).count;
+    } else {
+        idx = locate(list, logical_index, &offset);
+    }
+    if (idx != -1 && block(list, idx).count == UNROLLED_BLOCK) {
+        idx = make_room(list, idx, &offset);
+    }
+    if (idx == -1) {
+        LOGGER_ERROR("No block for insert at %lu", logical_index);
+        return ERROR_INSERT_FAIL;
+    }
+
+    unrolled_block_t& target = block(list, idx);
+    memmove(target.vals + offset + 1, target.vals + offset, (target.count - offset) * sizeof(double));
+    target.vals[offset] = val;
+    target.count++;
+    list->size++;
+    return checked(list);
+}
+
+error_code list_unrolled_remove_at(list_unrolled_t* list, size_t logical_index) {
+    HARD_ASSERT(list != nullptr,         "list is nullptr");
+    HARD_ASSERT(list->blocks != nullptr, "blocks is nullptr");
+
+    if (logical_index >= list->size) {
+        LOGGER_ERROR("list_unrolled_remove_at: index %lu out of range (size %lu)", logical_index, list->size);
+        return ERROR_INCORRECT_INDEX;
+    }
+    size_t  offset = 0;
+    ssize_t idx    = locate(list, logical_index, &offset);
+
+    unrolled_block_t& target = block(list, idx);
+    memmove(target.vals + offset, target.vals + offset + 1, (target.count - offset - 1) * sizeof(double));
+    target.count--;
+    list->size--;
+
+    if (target.count == 0) {
+        unlink_block(list, idx);
+        release_block(list, idx);
+    } else if (target.count < UNROLLED_MERGE) {
+        rebalance(list, idx);
+    }
+    return checked(list);
+}
+
+error_code list_unrolled_get(const list_unrolled_t* list, size_t logical_index, double* val_return) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(val_return != nullptr, "val_return is nullptr");
+
+    if (logical_index >= list->size) {
+        LOGGER_ERROR("list_unrolled_get: index %lu out of range (size %lu)", logical_index, list->size);
+        return ERROR_INCORRECT_INDEX;
+    }
+    size_t  offset = 0;
+    ssize_t idx    = locate(list, logical_index, &offset);
+    *val_return = block(list, idx).vals[offset];
+    return ERROR_NO;
+}
+
+error_code list_unrolled_set(list_unrolled_t* list, size_t logical_index, double val) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (logical_index >= list->size) {
+        LOGGER_ERROR("list_unrolled_set: index %lu out of range (size %lu)", logical_index, list->size);
+        return ERROR_INCORRECT_INDEX;
+    }
+    size_t  offset = 0;
+    ssize_t idx    = locate(list, logical_index, &offset);
+    block(list, idx).vals[offset] = val;
+    return ERROR_NO;
+}
+
+error_code list_unrolled_push_back(list_unrolled_t* list, double val) {
+    return list_unrolled_insert_at(list, list->size, val);
+}
+
+error_code list_unrolled_push_front(list_unrolled_t* list, double val) {
+    return list_unrolled_insert_at(list, 0, val);
+}
+
+error_code list_unrolled_pop_back(list_unrolled_t* list) {
+    if (list->size == 0) {
+        LOGGER_ERROR("list_unrolled_pop_back on an empty list");
+        return ERROR_INCORRECT_INDEX;
+    }
+    return list_unrolled_remove_at(list, list->size - 1);
+}
+
+error_code list_unrolled_pop_front(list_unrolled_t* list) {
+    if (list->size == 0) {
+        LOGGER_ERROR("list_unrolled_pop_front on an empty list");
+        return ERROR_INCORRECT_INDEX;
+    }
+    return list_unrolled_remove_at(list, 0);
+}
+
+error_code list_unrolled_linearize(list_unrolled_t* list) {
+    HARD_ASSERT(list != nullptr,         "list is nullptr");
+    HARD_ASSERT(list->blocks != nullptr, "blocks is nullptr");
+    LOGGER_DEBUG("Linearizing unrolled list of %lu values", list->size);
+
+    // every live block holds at most UNROLLED_BLOCK values, so the packed
+    // layout never needs more blocks than the list has now
+    unrolled_block_t* blocks = (unrolled_block_t*)malloc(list->capacity * sizeof(unrolled_block_t));
+    if (blocks == nullptr) {
+        LOGGER_ERROR("malloc failed in list_unrolled_linearize");
+        return ERROR_MEM_ALLOC;
+    }
+    const ssize_t packed = (ssize_t)((list->size + UNROLLED_BLOCK - 1) / UNROLLED_BLOCK);
+    ssize_t out = 0;
+    for (ssize_t cur = block(list, 0).next; cur != 0; cur = block(list, cur).next) {
+        const unrolled_block_t& src = block(list, cur);
+        for (size_t taken = 0; taken < src.count; ) {
+            if (out == 0 || blocks[out].count == UNROLLED_BLOCK) {
+                ++out;
+                blocks[out].count = 0;
+            }
+            unrolled_block_t& dst = blocks[out];
+            size_t chunk = src.count - taken;
+            if (chunk > UNROLLED_BLOCK - dst.count) chunk = UNROLLED_BLOCK - dst.count;
+            memcpy(dst.vals + dst.count, src.vals + taken, chunk * sizeof(double));
+            dst.count = (uint32_t)(dst.count + chunk);
+            taken += chunk;
+        }
+    }
+    HARD_ASSERT(out == packed, "packed block count mismatch");
+    for (ssize_t i = 1; i <= packed; ++i) {
+        blocks[i].next = as_index(i == packed ? 0 : i + 1);
+        blocks[i].prev = as_index(i - 1);
+    }
+    blocks[0].next  = as_index(packed > 0 ? 1 : 0);
+    blocks[0].prev  = as_index(packed);
+    blocks[0].count = 0;
+
+    free(list->blocks);
+    list->blocks    = blocks;
+    list->untouched = (size_t)packed + 1;
+    list->used      = (size_t)packed + 1;
+    list->free_head = -1;
+    return checked(list);
+}
+
+error_code list_unrolled_shrink_to_fit(list_unrolled_t* list, bool keep_growth) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    LOGGER_DEBUG("Shrinking unrolled list to fit (keep_growth=%d)", (int)keep_growth);
+
+    error_code error = list_unrolled_linearize(list);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    size_t target = list->used;
+    if (keep_growth) {
+        target = (size_t)((double)list->used * (double)GROWTH_FACTOR);
+    }
+    if (target < MIN_LIST_SIZE) target = MIN_LIST_SIZE;
+    if (target >= list->capacity) {
+        return ERROR_NO;
+    }
+    error = resize_blocks(list, target);
+    if (error != ERROR_NO) {
+        return error;
+    }
+    return checked(list);
+}
+
+error_code list_unrolled_verify(const list_unrolled_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    if (list->blocks == nullptr || list->untouched == 0 || list->untouched > list->capacity ||
+        list->used > list->untouched) {
+        LOGGER_ERROR("unrolled list header broken (capacity %lu, untouched %lu, used %lu)",
+                     list->capacity, list->untouched, list->used);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    size_t  values = 0;
+    size_t  linked = 1;
+    ssize_t prev   = 0;
+    for (ssize_t cur = block(list, 0).next; cur != 0; prev = cur, cur = block(list, cur).next) {
+        if (cur < 0 || (size_t)cur >= list->untouched || ++linked > list->used ||
+            block(list, cur).prev != prev) {
+            LOGGER_ERROR("unrolled chain broken at block %ld", cur);
+            return ERROR_INVALID_STRUCTURE;
+        }
+        const uint32_t count = block(list, cur).count;
+        if (count == 0 || count > UNROLLED_BLOCK) {
+            LOGGER_ERROR("unrolled block %ld holds %u values", cur, count);
+            return ERROR_INVALID_STRUCTURE;
+        }
+        values += count;
+    }
+    if (linked != list->used || block(list, 0).prev != prev || values != list->size) {
+        LOGGER_ERROR("unrolled list links %lu blocks / %lu values, header says %lu / %lu",
+                     linked, values, list->used, list->size);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    size_t free_blocks = 0;
+    for (ssize_t cur = list->free_head; cur != -1; cur = block(list, cur).next) {
+        if (cur <= 0 || (size_t)cur >= list->untouched || block(list, cur).prev != POISON ||
+            ++free_blocks > list->untouched) {
+            LOGGER_ERROR("unrolled free chain broken at block %ld", cur);
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    if (free_blocks + list->used != list->untouched) {
+        LOGGER_ERROR("unrolled list: %lu free + %lu used != %lu touched blocks",
+                     free_blocks, list->used, list->untouched);
+        return ERROR_INVALID_STRUCTURE;
+    }
+    return ERROR_NO;
+}
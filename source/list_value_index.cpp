@@ -0,0 +1,263 @@
+#include "list_value_index.h"
+#include "list_operations.h"
+#include "list_info.h"
+#include "logger.h"
+#include "asserts.h"
+#include "error_handler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t MIN_INDEX_CAPACITY = 16;
+
+//==============================================================================
+
+static inline uint64_t key_of(double val);
+static inline size_t   home_of(const list_value_index_t* index, uint64_t key);
+static ssize_t         find_entry(const list_value_index_t* index, uint64_t key, ssize_t slot);
+static void            put_entry(list_value_index_t* index, uint64_t key, list_index_t slot);
+static void            erase_entry(list_value_index_t* index, size_t pos);
+static error_code      rehash(list_value_index_t* index, size_t capacity);
+
+//==============================================================================
+
+// -0.0 and 0.0 compare equal, so they share a key
+static inline uint64_t key_of(double val) {
+    uint64_t key = 0;
+    memcpy(&key, &val, sizeof(key));
+    return (key << 1) == 0 ? 0 : key;
+}
+
+static inline size_t home_of(const list_value_index_t* index, uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return (size_t)key & (index->capacity - 1);
+}
+
+// Entry holding key (and slot, unless slot is -1), -1 if there is none
+static ssize_t find_entry(const list_value_index_t* index, uint64_t key, ssize_t slot) {
+    const size_t mask = index->capacity - 1;
+    for (size_t pos = home_of(index, key); index->entries[pos].slot != -1; pos = (pos + 1) & mask) {
+        const list_value_entry_t& entry = index->entries[pos];
+        if (entry.key == key && (slot == -1 || entry.slot == slot)) {
+            return (ssize_t)pos;
+        }
+    }
+    return -1;
+}
+
+static void put_entry(list_value_index_t* index, uint64_t key, list_index_t slot) {
+    const size_t mask = index->capacity - 1;
+    size_t pos = home_of(index, key);
+    while (index->entries[pos].slot != -1) {
+        pos = (pos + 1) & mask;
+    }
+    index->entries[pos].key  = key;
+    index->entries[pos].slot = slot;
+    index->count++;
+}
+
+// Backward-shift deletion: later entries of the probe run move up into the
+// hole, so lookups never need tombstones
+static void erase_entry(list_value_index_t* index, size_t pos) {
+    const size_t mask = index->capacity - 1;
+    size_t hole = pos;
+    for (size_t cur = (pos + 1) & mask; index->entries[cur].slot != -1; cur = (cur + 1) & mask) {
+        size_t home = home_of(index, index->entries[cur].key);
+        if (((cur - home) & mask) >= ((cur - hole) & mask)) {
+            index->entries[hole] = index->entries[cur];
+            hole = cur;
+        }
+    }
+    index->entries[hole].slot = -1;
+    index->count--;
+}
+
+static error_code rehash(list_value_index_t* index, size_t capacity) {
+    list_value_entry_t* entries = (list_value_entry_t*)malloc(capacity * sizeof(list_value_entry_t));
+    if (entries == nullptr) {
+        LOGGER_ERROR("malloc failed for value index of %lu entries", capacity);
+        return ERROR_MEM_ALLOC;
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        entries[i].slot = -1;
+    }
+
+    list_value_entry_t* old_entries  = index->entries;
+    size_t              old_capacity = index->capacity;
+    index->entries  = entries;
+    index->capacity = capacity;
+    index->count    = 0;
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].slot != -1) {
+            put_entry(index, old_entries[i].key, old_entries[i].slot);
+        }
+    }
+    free(old_entries);
+    return ERROR_NO;
+}
+
+//==============================================================================
+
+error_code list_value_index_enable(list_t* list) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+    LOGGER_DEBUG("Enabling value index");
+
+    if (list->pool != nullptr) {
+        LOGGER_ERROR("Value index is not available for lists in a node pool");
+        return ERROR_INCORRECT_ARGS;
+    }
+    if (list->value_index != nullptr) {
+        return ERROR_NO;
+    }
+    list_value_index_t* index = (list_value_index_t*)calloc(1, sizeof(list_value_index_t));
+    if (index == nullptr) {
+        LOGGER_ERROR("calloc failed for value index");
+        return ERROR_MEM_ALLOC;
+    }
+    list->value_index = index;
+    value_index_rebuild(list);
+    return list->value_index != nullptr ? ERROR_NO : ERROR_MEM_ALLOC;
+}
+
+void list_value_index_disable(list_t* list) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+
+    list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return;
+    }
+    LOGGER_DEBUG("Disabling value index");
+    free(index->entries);
+    free(index);
+    list->value_index = nullptr;
+}
+
+ssize_t list_find(const list_t* list, double val) {
+    HARD_ASSERT(list != nullptr,       "list is nullptr");
+    HARD_ASSERT(list_storage_ok(list), "arr is nullptr");
+
+    const uint64_t key = key_of(val);
+    const list_value_index_t* index = list->value_index;
+    if (index != nullptr) {
+        ssize_t pos = find_entry(index, key, -1);
+        return pos == -1 ? -1 : index->entries[pos].slot;
+    }
+    for (ssize_t cur = list->head; cur != 0; cur = node_next(list, cur)) {
+        if (key_of(node_val(list, cur)) == key) {
+            return cur;
+        }
+    }
+    return -1;
+}
+
+bool list_contains(const list_t* list, double val) {
+    return list_find(list, val) != -1;
+}
+
+error_code list_remove_value(list_t* list, double val) {
+    HARD_ASSERT(list != nullptr, "list is nullptr");
+    LOGGER_DEBUG("Removing value %lf", val);
+
+    ssize_t physical_index = list_find(list, val);
+    if (physical_index == -1) {
+        LOGGER_DEBUG("list_remove_value: %lf is not in the list", val);
+        return ERROR_MISSED_ELEM;
+    }
+    return list_remove(list, physical_index);
+}
+
+//==============================================================================
+
+void value_index_link(list_t* list, ssize_t idx) {
+    list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return;
+    }
+    // load factor stays at or below 1/2
+    if ((index->count + 1) * 2 > index->capacity &&
+        rehash(index, index->capacity * 2) != ERROR_NO) {
+        LOGGER_ERROR("Value index could not grow, disabling it");
+        list_value_index_disable(list);
+        return;
+    }
+    put_entry(index, key_of(node_val(list, idx)), as_index(idx));
+}
+
+void value_index_unlink(list_t* list, ssize_t idx) {
+    list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return;
+    }
+    ssize_t pos = find_entry(index, key_of(node_val(list, idx)), idx);
+    HARD_ASSERT(pos != -1, "node is missing from the value index");
+    erase_entry(index, (size_t)pos);
+}
+
+// Called after the swap: the node that sat in first_idx is in second_idx now
+// and the other way round
+void value_index_swap(list_t* list, ssize_t first_idx, ssize_t second_idx) {
+    list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return;
+    }
+    ssize_t from_first  = -1;
+    ssize_t from_second = -1;
+    if (!list_node_is_free(list, second_idx)) {
+        from_first = find_entry(index, key_of(node_val(list, second_idx)), first_idx);
+    }
+    if (!list_node_is_free(list, first_idx)) {
+        from_second = find_entry(index, key_of(node_val(list, first_idx)), second_idx);
+    }
+    if (from_first  != -1) index->entries[from_first].slot  = as_index(second_idx);
+    if (from_second != -1) index->entries[from_second].slot = as_index(first_idx);
+}
+
+// Every node moved at once: cheaper to index the chain afresh
+void value_index_rebuild(list_t* list) {
+    list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return;
+    }
+    size_t capacity = MIN_INDEX_CAPACITY;
+    while (capacity < 2 * (list->size - 1)) {
+        capacity *= 2;
+    }
+    free(index->entries);
+    index->entries  = nullptr;
+    index->capacity = 0;
+    index->count    = 0;
+    if (rehash(index, capacity) != ERROR_NO) {
+        LOGGER_ERROR("Value index could not be rebuilt, disabling it");
+        list_value_index_disable(list);
+        return;
+    }
+    for (ssize_t cur = list->head; cur != 0; cur = node_next(list, cur)) {
+        put_entry(index, key_of(node_val(list, cur)), as_index(cur));
+    }
+}
+
+error_code value_index_verify(const list_t* list, const char** error_description) {
+    const list_value_index_t* index = list->value_index;
+    if (index == nullptr) {
+        return ERROR_NO;
+    }
+    if (index->count != list->size - 1 || index->count * 2 > index->capacity) {
+        LOGGER_ERROR("value index holds %lu entries in %lu, list has %lu nodes",
+                     index->count, index->capacity, list->size - 1);
+        *error_description = "value index count mismatch";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    for (ssize_t cur = list->head; cur != 0; cur = node_next(list, cur)) {
+        if (find_entry(index, key_of(node_val(list, cur)), cur) == -1) {
+            LOGGER_ERROR("node %ld (%lf) is missing from the value index", cur, node_val(list, cur));
+            *error_description = "value index missing node";
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    return ERROR_NO;
+}
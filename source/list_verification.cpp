@@ -2,6 +2,9 @@
 #include "logger.h"
 #include "error_handler.h"
 #include "asserts.h"
+#include "list_order_index.h"
+#include "list_handles.h"
+#include "list_value_index.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -111,6 +114,12 @@ static inline int idx_ok(ssize_t idx, size_t capacity) {
     return idx >= 0 && (size_t)idx < capacity;
 }
 
+// Slots at or past list->untouched were never written and hold garbage
+static inline size_t used_slots(const list_t* list) {
+    list = list_store(list);
+    return list->untouched < list->capacity ? list->untouched : list->capacity;
+}
+
 static error_code validate_main_chain(const list_t* list, size_t capacity, const char** error_description) {
     error_code error = 0;
     if (!idx_ok(list->head, capacity)) return 0;
@@ -122,10 +131,10 @@ static error_code validate_main_chain(const list_t* list, size_t capacity, const
     size_t steps = 0;
     while (idx_ok(curr, capacity) && curr > 0 && !seen[curr]) {
         seen[curr] = 1;
-        ssize_t next = list->arr[curr].next;
+        ssize_t next = node_next(list, curr);
 
         if (idx_ok(next, capacity)) {
-            if (list->arr[next].prev != curr) {
+            if (node_prev(list, next) != curr) {
                 LOGGER_ERROR("mismatch prev for %ld <- %ld", next, curr);
                 *error_description = "mismatch in main chain";
                 error |= ERROR_INVALID_STRUCTURE;
@@ -155,11 +164,17 @@ static error_code validate_free_chain(const list_t* list, size_t capacity, const
     char* seen = (char*)calloc(capacity, 1);
     if (!seen) { LOGGER_ERROR("alloc failed (free)"); return ERROR_MEM_ALLOC; }
 
+    if (node_prev(list, list->free_head) != -1) {
+        LOGGER_ERROR("free_head %ld has prev %ld", list->free_head, (ssize_t)node_prev(list, list->free_head));
+        *error_description = "free_head has a predecessor";
+        error |= ERROR_INVALID_STRUCTURE;
+    }
+
     ssize_t curr = list->free_head;
     size_t steps = 0;
     while (idx_ok(curr, capacity) && curr > 0 && !seen[curr]) {
         seen[curr] = 1;
-        ssize_t next = list->arr[curr].next;
+        ssize_t next = node_next(list, curr);
 
         if (next != -1 && !idx_ok(next, capacity)) {
             LOGGER_ERROR("free next not in chain %ld -> %ld", curr, next);
@@ -167,6 +182,11 @@ static error_code validate_free_chain(const list_t* list, size_t capacity, const
             error |= ERROR_INVALID_STRUCTURE;
             break;
         }
+        if (next != -1 && node_prev(list, next) != curr) {
+            LOGGER_ERROR("mismatch prev for free %ld <- %ld", next, curr);
+            *error_description = "mismatch in free chain";
+            error |= ERROR_INVALID_STRUCTURE;
+        }
         curr = next;
         if (++steps > capacity + 1) {
             LOGGER_ERROR("loop suspected in free-chain");
@@ -179,6 +199,57 @@ static error_code validate_free_chain(const list_t* list, size_t capacity, const
     return error;
 }
 
+static error_code validate_linear_prefix(const list_t* list, size_t used, const char** error_description) {
+    const size_t prefix = list->linear_prefix;
+    if (prefix + 1 > list->size || prefix >= used) {
+        LOGGER_ERROR("linear_prefix(%zu) out of range", prefix);
+        *error_description = "linear_prefix out of range";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    ssize_t expected = 1;
+    for (ssize_t curr = list->head; (size_t)expected <= prefix; curr = node_next(list, curr), ++expected) {
+        if (curr != expected) {
+            LOGGER_ERROR("linear_prefix(%zu) broken at logical %ld (physical %ld)", prefix, expected - 1, curr);
+            *error_description = "linear_prefix broken";
+            return ERROR_INVALID_STRUCTURE;
+        }
+    }
+    return ERROR_NO;
+}
+
+static error_code validate_finger(const list_t* list, const char** error_description) {
+    if (list->finger_physical == 0) {
+        return ERROR_NO;
+    }
+    ssize_t curr = list->head;
+    for (ssize_t i = 0; curr != 0 && i < list->finger_logical; ++i) {
+        curr = node_next(list, curr);
+    }
+    if (list->finger_logical < 0 || curr != list->finger_physical) {
+        LOGGER_ERROR("finger (%ld -> %ld) does not match the chain (%ld)",
+                     list->finger_logical, list->finger_physical, curr);
+        *error_description = "finger out of sync";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    return ERROR_NO;
+}
+
+static error_code validate_seq_links(const list_t* list, const char** error_description) {
+    size_t  seq  = 0;
+    ssize_t prev = 0;
+    for (size_t i = 1; i < list->size; ++i) {
+        ssize_t curr = node_next(list, prev);
+        if (curr == prev + 1) ++seq;
+        prev = curr;
+    }
+    if (seq != list->seq_links) {
+        LOGGER_ERROR("seq_links(%zu) != %zu sequential links in the chain", list->seq_links, seq);
+        *error_description = "seq_links out of sync";
+        return ERROR_INVALID_STRUCTURE;
+    }
+    return ERROR_NO;
+}
+
 error_code list_verify(list_t* list,
                        ver_info_t ver_info,
                        dump_mode_t mode,
@@ -201,18 +272,25 @@ error_code list_verify(list_t* list,
         return error;
     }
 
-    const size_t capacity = list->capacity;
+    // A pool list is checked against the pool's slots and free chain
+    const list_t* store   = list_store(list);
+    const size_t capacity = store->capacity;
 
     if (capacity == 0) {
         LOGGER_ERROR("capacity == 0");
         error_description = "capacity == 0";
         error |= ERROR_INVALID_STRUCTURE;
     }
-    if (!list->arr) {
+    if (!list_storage_ok(list)) {
         LOGGER_ERROR("arr is NULL");
         error_description = "arr is NULL";
         error |= ERROR_NULL_ARG;
     }
+    if (capacity > LIST_MAX_CAPACITY) {
+        LOGGER_ERROR("capacity(%zu) exceeds index range (%zu)", capacity, LIST_MAX_CAPACITY);
+        error_description = "capacity exceeds index range";
+        error |= ERROR_BIG_SIZE;
+    }
     if (list->size > capacity) {
         LOGGER_ERROR("size(%zu) > capacity(%zu)", list->size, capacity);
         error_description = "size > capacity";
@@ -223,32 +301,48 @@ error_code list_verify(list_t* list,
         error_description = "head out of bounds";
         error |= ERROR_INVALID_STRUCTURE;
     }
-    if (list->free_head != -1 && !idx_ok(list->free_head, capacity)) {
-        LOGGER_WARNING("free_head out of bounds: %ld", list->free_head);
+    if (store->untouched == 0 || store->untouched > capacity) {
+        LOGGER_ERROR("untouched(%zu) outside [1, capacity(%zu)]", store->untouched, capacity);
+        error_description = "untouched out of bounds";
+        error |= ERROR_INVALID_STRUCTURE;
+    }
+    const size_t used = used_slots(list);
+    if (store->free_head != -1 && !idx_ok(store->free_head, used)) {
+        LOGGER_WARNING("free_head out of bounds: %ld", store->free_head);
         error_description = "free_head out of bounds";
         error |= ERROR_INVALID_STRUCTURE;
     }
 
-    if (list->arr && capacity > 0) {
-        if (list->arr[0].val != CANARY_NUM) {
-            LOGGER_ERROR("Left canary corrupted: expected %g, got %g", CANARY_NUM, list->arr[0].val);
+    if (list_storage_ok(list) && capacity > 0) {
+        if (node_val(list, 0) != CANARY_NUM) {
+            LOGGER_ERROR("Left canary corrupted: expected %g, got %g", CANARY_NUM, node_val(list, 0));
             error_description = "left canary corrupted";
             error |= ERROR_CANARY;
         }
-        if (list->arr[capacity].val != CANARY_NUM) {
-            LOGGER_ERROR("Right canary corrupted: expected %g, got %g", CANARY_NUM, list->arr[capacity].val);
+        if (node_val(list, capacity) != CANARY_NUM) {
+            LOGGER_ERROR("Right canary corrupted: expected %g, got %g", CANARY_NUM, node_val(list, capacity));
             error_description = "right canary corrupted";
             error |= ERROR_CANARY;
         }
         
-        error |= validate_main_chain(list, capacity, &error_description);
-        error |= validate_free_chain(list, capacity, &error_description);
+        error |= validate_main_chain(list, used, &error_description);
+        error |= validate_free_chain(store, used, &error_description);
+        if (error == ERROR_NO) {
+            error |= validate_linear_prefix(list, used, &error_description);
+            error |= validate_seq_links(list, &error_description);
+            error |= validate_finger(list, &error_description);
+        }
+        if (error == ERROR_NO) {
+            error |= order_index_verify(list, &error_description);
+            error |= handles_verify(list, &error_description);
+            error |= value_index_verify(list, &error_description);
+        }
         error_description = "Corrupted chain";
     }
 
     if (error != 0 && mode != DUMP_NO) {
         const bool want_visual = (mode == DUMP_IMG);
-        const bool can_visual  = want_visual && list->arr && (capacity > 0);
+        const bool can_visual  = want_visual && list_storage_ok(list) && (capacity > 0);
         list_dump(list, ver_info, can_visual, "List_verify: %s\n Comment: %s", error_description, comment);
     }
     return error;
@@ -273,7 +367,7 @@ void list_dump(list_t* list,
     snprintf(base, sizeof(base), "dumps/dump_%03d", dump_idx);
 
     char svg_path[300] = "";
-    if (is_visual && list && list->arr && list->capacity > 0) {
+    if (is_visual && list && list_storage_ok(list) && list_store(list)->capacity > 0) {
         if (dump_make_graphviz_svg(list, base)) {
             snprintf(svg_path, sizeof(svg_path), "%s.svg", base);
         } else {
@@ -317,13 +411,14 @@ int dump_make_graphviz_svg(const list_t* list, const char* base_name) {
         "  node_0[shape=record,"
         "label=\"ind: 0 | val: %g | { prev: %ld | next: %ld }\"," 
         "color=\"" ELEM_0_BORDER "\",style=\"filled,bold,rounded\",fillcolor=\"" ELEM_0_BACK "\"];\n",
-        list->arr[0].val, list->arr[0].prev, list->arr[0].next);
+        node_val(list, 0), (ssize_t)node_prev(list, 0), (ssize_t)node_next(list, 0));
 
     emit_nodes(list, file);
-    emit_invis_rank_edges(list->capacity, file);
+    emit_invis_rank_edges(used_slots(list), file);
 
-    char *bidir_next = (char*)calloc(list->capacity, 1);
-    char *bidir_prev = (char*)calloc(list->capacity, 1);
+    const list_t* store = list_store(list);
+    char *bidir_next = (char*)calloc(store->capacity, 1);
+    char *bidir_prev = (char*)calloc(store->capacity, 1);
     if (!bidir_next || !bidir_prev) {
         free(bidir_next);
         free(bidir_prev);
@@ -339,9 +434,16 @@ int dump_make_graphviz_svg(const list_t* list, const char* base_name) {
     free(bidir_next);
     free(bidir_prev);
 
+    if (store->untouched < store->capacity) {
+        fprintf(file,
+            "  node_untouched [label=\"untouched: %zu..%zu\",color=\"" FREE_NODE_BORDER "\",shape=rectangle,"
+            "style=\"filled,rounded,dashed\",fillcolor=\"" FREE_NODE_BACK "\"];\n",
+            store->untouched, store->capacity - 1);
+        fprintf(file, "  node_%zu -> node_untouched [weight=1000,style=invis];\n", used_slots(list) - 1);
+    }
     fprintf(file,
         "  node_free [label=free_head,color=\"" FREE_NODE_BORDER  "\",shape=rectangle,style=\"filled,rounded\",fillcolor=\"" FREE_NODE_BACK "\"];\n");
-    fprintf(file, "  node_free -> node_%ld [color=\"" EDGE_FREE "\", style=dashed, constraint=false];\n", list->free_head);
+    fprintf(file, "  node_free -> node_%ld [color=\"" EDGE_FREE "\", style=dashed, constraint=false];\n", store->free_head);
 
     fprintf(file, "}\n");
     fclose(file);
@@ -352,13 +454,13 @@ int dump_make_graphviz_svg(const list_t* list, const char* base_name) {
 //------------------------------------------------------------------------------
 
 static void emit_nodes(const list_t *list, FILE *file) {
-    const size_t capacity = list->capacity;
-    for (size_t i = 1; i < capacity; ++i) {
-        const ssize_t next_index  = list->arr[i].next;
-        const ssize_t prev_index  = list->arr[i].prev;
-        const double val      = list->arr[i].val;
+    const size_t used = used_slots(list);
+    for (size_t i = 1; i < used; ++i) {
+        const ssize_t next_index  = node_next(list, i);
+        const ssize_t prev_index  = node_prev(list, i);
+        const double val      = node_val(list, i);
 
-        const ssize_t is_free = (prev_index == -1 || val == POISON);
+        const ssize_t is_free = (val == POISON);
         const ssize_t is_head = (i == (size_t)list->head);
         const ssize_t is_tail = (i == (size_t)list->tail);
 
@@ -423,12 +525,12 @@ static void emit_bad_box_and_link(
 //------------------------------------------------------------------------------
 
 static void emit_edges_free(const list_t *list, FILE *file) {
-    const size_t capacity = list->capacity;
-    for (size_t i = 0; i < capacity; ++i) {
-        const ssize_t prev_index = list->arr[i].prev;
-        if (prev_index != -1) continue; 
+    const size_t capacity = list_store(list)->capacity;
+    const size_t used     = used_slots(list);
+    for (size_t i = 0; i < used; ++i) {
+        if (!list_node_is_free(list, i)) continue;
 
-        const ssize_t next_index = list->arr[i].next;
+        const ssize_t next_index = node_next(list, i);
         if (next_index >= 0 && (size_t)next_index < capacity) {
             fprintf(file,
                 "  node_%zu -> node_%ld [color=\"" EDGE_FREE "\", style=dashed, constraint=false];\n",
@@ -441,14 +543,14 @@ static void emit_edges_free(const list_t *list, FILE *file) {
 }
 
 static void emit_edges_next(const list_t *list, char *bidir_next, char *bidir_prev, FILE *file) {
-    const size_t capacity = list->capacity;
-    for (size_t i = 0; i < capacity; ++i) {
-        const ssize_t prev_index = list->arr[i].prev;
-        if (prev_index == -1) continue; 
+    const size_t capacity = list_store(list)->capacity;
+    const size_t used     = used_slots(list);
+    for (size_t i = 0; i < used; ++i) {
+        if (list_node_is_free(list, i)) continue;
 
-        const ssize_t next_index = list->arr[i].next;
+        const ssize_t next_index = node_next(list, i);
         if (next_index >= 0 && (size_t)next_index < capacity) {
-            if (list->arr[next_index].prev == (ssize_t)i) {
+            if (node_prev(list, next_index) == (ssize_t)i) {
                 if (!bidir_next[i]) {
                     fprintf(file,
                         "  node_%zu -> node_%ld [dir=both, color=\"" EDGE_BASIC "\", constraint=false];\n",
@@ -468,13 +570,14 @@ static void emit_edges_next(const list_t *list, char *bidir_next, char *bidir_pr
 }
 
 static void emit_edges_prev(const list_t *list, char *bidir_next, char *bidir_prev, FILE *file) {
-    const size_t capacity = list->capacity;
-    for (size_t i = 0; i < capacity; ++i) {
-        const ssize_t prev_index = list->arr[i].prev;
-        if (prev_index == -1) continue; 
+    const size_t capacity = list_store(list)->capacity;
+    const size_t used     = used_slots(list);
+    for (size_t i = 0; i < used; ++i) {
+        const ssize_t prev_index = node_prev(list, i);
+        if (list_node_is_free(list, i)) continue;
 
         if (prev_index >= 0 && (size_t)prev_index < capacity) {
-            if (list->arr[prev_index].next == (ssize_t)i) {
+            if (node_next(list, prev_index) == (ssize_t)i) {
                 if (!bidir_prev[i]) {
                     fprintf(file,
                         "  node_%ld -> node_%zu [dir=both, color=\"" EDGE_BASIC "\", constraint=false];\n",
@@ -539,13 +642,37 @@ static void dump_write_html(const list_t* list, ver_info_t ver_info_called, int
     fprintf(html,
         "<span style=\"color:" HTML_BORDER ";font-weight:700;\">===================================================</span>\n");
 
+    const list_t* store = list ? list_store(list) : NULL;
     fprintf(html, "list ptr : %p\n",  list);
-    fprintf(html, "arr  ptr : %p\n",  list ? list->arr      :  NULL);
-    fprintf(html, "capacity : %zu\n", list ? list->capacity :  0);
+    if (list && list->pool) {
+        fprintf(html, "pool     : %p (sentinel slot %ld)\n", list->pool, list->sentinel);
+    }
+#ifdef LIST_SOA
+    fprintf(html, "next ptr : %p\n",  store ? store->next     :  NULL);
+    fprintf(html, "prev ptr : %p\n",  store ? store->prev     :  NULL);
+    fprintf(html, "val  ptr : %p\n",  store ? store->val      :  NULL);
+#else
+    fprintf(html, "arr  ptr : %p\n",  store ? store->arr      :  NULL);
+#endif
+    fprintf(html, "chunks   : %zu%s\n", store ? store->chunk_count : 0,
+            store && store->storage_kind == LIST_STORAGE_CHUNKED ? " (chunked storage)" : "");
+    fprintf(html, "capacity : %zu\n", list ? store->capacity :  0);
     fprintf(html, "size     : %zu\n", list ? list->size     :  0);
     fprintf(html, "head     : %ld\n",  list ? list->head     : -1);
     fprintf(html, "tail     : %ld\n",  list ? list->tail     : -1);
-    fprintf(html, "free_head: %ld\n",  list ? list->free_head: -1);
+    fprintf(html, "free_head: %ld\n",  list ? store->free_head: -1);
+    fprintf(html, "untouched: %zu\n", list ? store->untouched:  0);
+    fprintf(html, "linear   : %zu%s\n", list ? list->linear_prefix : 0,
+            list && list_is_linear(list) ? " (whole list)" : "");
+    fprintf(html, "locality : %.3f (%zu sequential links)\n", list ? list_locality(list) : 1.0,
+            list ? list->seq_links : 0);
+    fprintf(html, "finger   : %s%ld -> %ld\n", list && list->finger_physical ? "" : "(unset) ",
+            list ? list->finger_logical : 0, list ? list->finger_physical : 0);
+    fprintf(html, "handles  : %s\n", !list || !list->handles ? "off" :
+                                      list->handles->origin ? "on (recording remap)" : "on");
+    fprintf(html, "value idx: %s\n", !list || !list->value_index ? "off" : "on");
+    fprintf(html, "order idx: %s\n", !list || !list->order_index ? "off" :
+                                      list->order_index->stale   ? "on (stale)" : "on");
 
     fprintf(html, "\n-- Created at (list ver_info) --\n");
     fprintf(html, "file: %s\n",   ver_info_created.file);
@@ -557,22 +684,22 @@ static void dump_write_html(const list_t* list, ver_info_t ver_info_called, int
     fprintf(html, "func: %s\n",   ver_info_called.func);
     fprintf(html, "line: %d\n",   ver_info_called.line);
 
-    if (list && list->arr && list->capacity > 0) {
+    if (list && list_storage_ok(list) && store->capacity > 0) {
         fprintf(html, "\n-- Canaries --\n");
         fprintf(html, "Expected canary value: %g\n", CANARY_NUM);
-        fprintf(html, "left : %g\n", list->arr[0].val); 
-        fprintf(html, "right: %g\n", list->arr[list->capacity].val);
+        fprintf(html, "left : %g\n", node_val(list, 0)); 
+        fprintf(html, "right: %g\n", node_val(list, store->capacity));
     }
 
-    if (list && list->arr && list->capacity > 0) {
+    if (list && list_storage_ok(list) && store->capacity > 0) {
         fprintf(html, "\n");
         fprintf(html, "IDX   NEXT   PREV        VALUE     MARKS\n");
         fprintf(html, "----  ------ ------  ------------  -----\n");
 
-        for (size_t i = 0; i < list->capacity; ++i) {
-            ssize_t next =  list->arr[i].next;
-            ssize_t  prv =  list->arr[i].prev;
-            double   val =  list->arr[i].val;
+        for (size_t i = 0; i < used_slots(list); ++i) {
+            ssize_t next =  node_next(list, i);
+            ssize_t  prv =  node_prev(list, i);
+            double   val =  node_val(list, i);
             if(val == POISON) val = POISON;
 
             char marks[32]; marks[0] = '\0';
@@ -581,7 +708,7 @@ static void dump_write_html(const list_t* list, ver_info_t ver_info_called, int
             if (i == 0)                       {strcat(marks,         "ZERO"          ); first = 0;}
             if ((ssize_t)i == list->head)     {strcat(marks, first ? "HEAD" : ",HEAD"); first = 0;}
             if ((ssize_t)i == list->tail)     {strcat(marks, first ? "TAIL" : ",TAIL"); first = 0;}
-            if ((ssize_t)i == list->free_head){strcat(marks, first ? "FREE" : ",FREE"); first = 0;}
+            if ((ssize_t)i == store->free_head){strcat(marks, first ? "FREE" : ",FREE"); first = 0;}
 
             fprintf(html, "%-4zu  %-6ld %-6ld  %-12.6g  %-5s",
                     i, next, prv, val, marks);
@@ -590,6 +717,9 @@ static void dump_write_html(const list_t* list, ver_info_t ver_info_called, int
             }
             fprintf(html, "\n");
         }
+        if (store->untouched < store->capacity) {
+            fprintf(html, "%zu..%zu  (UNTOUCHED)\n", store->untouched, store->capacity - 1);
+        }
     } else {
         fprintf(html, "\n(arr is NULL or capacity == 0)\n");
     }
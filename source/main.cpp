@@ -5,6 +5,7 @@
 #include "handle_input.h"
 #include "list_operations.h"
 #include "list_verification.h"
+#include "list_bench.h"
 
 static error_code choose_input_type_and_process(list_t* list, int argc, char* argv[]);
 
@@ -112,19 +113,19 @@ static error_code choose_input_type_and_process(list_t* list, int argc, char* ar
         list_dump(list, VER_INIT, true, "After removes");
         list_insert_after(list, 11, 15.0);
         list_insert_after(list, 11, 22.0);
-        list->arr[3].prev = 150; // to trigger error in dump
+        node_prev(list, 3) = 150; // to trigger error in dump
         list_dump(list, VER_INIT, true, "Corrupted dump");
 
-        list->arr[8].next = 5;
+        node_next(list, 8) = 5;
         list_insert_auto(list, 1, 42.0);
         
-        list->arr[3].next = 150;
+        node_next(list, 3) = 150;
         list_dump(list, VER_INIT, true, "Corrupted dump 2");
 
-        list->arr[0].next = 3;
+        node_next(list, 0) = 3;
         list_dump(list, VER_INIT, true, "Corrupted dump 3");
 
-        list->arr[list->capacity].val = 0;
+        node_val(list, list->capacity) = 0;
         list_remove(list, 1);
 
 
@@ -147,7 +148,7 @@ static error_code choose_input_type_and_process(list_t* list, int argc, char* ar
         list_remove(list, 3);
         list_dump(list, VER_INIT, true, "After more operations");
 
-        list->arr[11].prev = 150;
+        node_prev(list, 11) = 150;
         list_dump(list, VER_INIT, true, "Corrupted dump free list");
 */
         ON_DEBUG(
@@ -155,6 +156,17 @@ static error_code choose_input_type_and_process(list_t* list, int argc, char* ar
         )
         return error;
 
+    } else if(strcmp(argv[1], "-b")  == 0) {
+        if(argc < 3) {
+            LOGGER_ERROR("FEW_ARGUMENTS %d", argc);
+            return ERROR_INCORRECT_ARGS;
+        }
+        size_t elem_count = 0;
+        if(argc > 3) {
+            elem_count = strtoul(argv[3], nullptr, 10);
+        }
+        return list_run_benchmark(argv[2], elem_count);
+
     } else {
         LOGGER_ERROR("Unknown arg: %s", argv[1]);
         return ERROR_INCORRECT_ARGS;